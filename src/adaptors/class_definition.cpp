@@ -1,16 +1,169 @@
 #include "class_definition.hpp"
-#include "../formatter/baksmali_writer.hpp"
 #include "../dex/dex_file.hpp"
 #include "../dex/dalvik_opcodes.hpp"
-#include <sstream>
+#include "../dex/method_labels.hpp"
 #include <algorithm>
 
-ClassDefinition::ClassDefinition(const DexClass& class_def, const BaksmaliOptions& options)
-    : class_def_(class_def), options_(options) {}
+namespace {
+
+void write_instruction(OutputBuffer& output, const DexCode& code, const DexInstruction& instruction,
+                       const DexFile& dex_file, const RegisterNaming& registers, const MethodLabels& labels) {
+    output << "    ";
+    switch (instruction.format) {
+        case InstructionFormat::FORMAT_PACKED_SWITCH_PAYLOAD:
+        case InstructionFormat::FORMAT_SPARSE_SWITCH_PAYLOAD:
+        case InstructionFormat::FORMAT_ARRAY_PAYLOAD:
+            DalvikInstructionParser::format_payload(instruction, code.insns, labels, output);
+            break;
+        default:
+            DalvikInstructionParser::format_instruction(instruction, &dex_file, registers, &labels, output);
+            break;
+    }
+    output << "\n";
+}
+
+// The :try_end_ label and one .catch/.catchall line per handler
+void write_try_end(OutputBuffer& output, const DexCode& code, const DexTryBlock& block, const DexFile& dex_file,
+                   const MethodLabels& labels) {
+    output << "    ";
+    labels.append_label(LabelKind::TRY_END, block.end_address, output);
+    output << "\n";
+
+    for (uint32_t i = block.handlers_begin; i < block.handlers_end; ++i) {
+        const DexCatchHandler& handler = code.catch_handlers[i];
+        bool catch_all = handler.type_idx == DexCatchHandler::CATCH_ALL;
+        if (catch_all) {
+            output << "    .catchall {";
+        } else {
+            output << "    .catch " << dex_file.get_type_name(handler.type_idx) << " {";
+        }
+        labels.append_label(LabelKind::TRY_START, block.start_address, output);
+        output << " .. ";
+        labels.append_label(LabelKind::TRY_END, block.end_address, output);
+        output << "} ";
+        labels.append_label(catch_all ? LabelKind::CATCHALL : LabelKind::CATCH, handler.address, output);
+        output << "\n";
+    }
+}
+
+// Kinds of item in a method body, each drawn from its own address-ordered source
+enum class MethodItemKind : uint8_t { DEBUG, LABEL, INSTRUCTION, TRY_END };
+
+// One method body item, ordered by (address, priority) as in baksmali.
+// `index` selects the debug item, instruction or try block it stands for.
+struct MethodItemKey {
+    uint32_t address;
+    int32_t priority;
+    MethodItemKind kind;
+    uint32_t index;
+
+    bool operator<(const MethodItemKey& other) const {
+        return address != other.address ? address < other.address : priority < other.priority;
+    }
+};
+
+// Priorities of debug directives; labels are 0, instructions 100 and try ends 101
+int32_t debug_priority(DebugItem::Type type) {
+    switch (type) {
+        case DebugItem::PROLOGUE_END:
+        case DebugItem::EPILOGUE_BEGIN: return -4;
+        case DebugItem::SET_SOURCE_FILE: return -3;
+        case DebugItem::LINE_NUMBER: return -2;
+        default: return -1;
+    }
+}
+
+// Debug items come out of the state machine in address order, so ordering
+// them by priority within an address is an insertion sort over a few keys.
+// .end local directives at one address go in ascending register order.
+std::pmr::vector<MethodItemKey> collect_debug_keys(const std::pmr::vector<DebugItem>& debug_items,
+                                                   std::pmr::memory_resource* resource) {
+    auto end_local_register = [&debug_items](const MethodItemKey& key) -> int64_t {
+        const DebugItem& item = debug_items[key.index];
+        return item.type == DebugItem::END_LOCAL ? item.register_num : -1;
+    };
+    auto before = [&](const MethodItemKey& a, const MethodItemKey& b) {
+        if (a < b || b < a) {
+            return a < b;
+        }
+        int64_t a_register = end_local_register(a);
+        int64_t b_register = end_local_register(b);
+        return a_register != -1 && b_register != -1 && a_register < b_register;
+    };
+
+    std::pmr::vector<MethodItemKey> keys(resource);
+    keys.reserve(debug_items.size());
+    for (uint32_t i = 0; i < debug_items.size(); ++i) {
+        const DebugItem& item = debug_items[i];
+        MethodItemKey key{item.address, debug_priority(item.type), MethodItemKind::DEBUG, i};
+        size_t position = keys.size();
+        keys.push_back(key);
+        while (position > 0 && before(key, keys[position - 1])) {
+            keys[position] = keys[position - 1];
+            --position;
+        }
+        keys[position] = key;
+    }
+    return keys;
+}
+
+// Linear merge of a method's debug items, labels, instructions and try ends.
+// Every source is already ordered, so each step takes the smallest head.
+class MethodItemMerge {
+public:
+    MethodItemMerge(const DexCode& code, const MethodLabels& labels, const std::pmr::vector<MethodItemKey>& debug_keys)
+        : code_(code), labels_(labels), debug_keys_(debug_keys), next_label_(labels.next_address(0)) {}
+
+    bool next(MethodItemKey& item) {
+        bool found = false;
+        auto consider = [&item, &found](const MethodItemKey& head) {
+            if (!found || head < item) {
+                item = head;
+                found = true;
+            }
+        };
+        if (next_debug_ < debug_keys_.size()) {
+            consider(debug_keys_[next_debug_]);
+        }
+        if (next_label_ != MethodLabels::NONE) {
+            consider({next_label_, 0, MethodItemKind::LABEL, 0});
+        }
+        if (next_instruction_ < code_.instructions.size()) {
+            consider({code_.instructions[next_instruction_].address, 100, MethodItemKind::INSTRUCTION, next_instruction_});
+        }
+        if (next_try_ < code_.tries.size()) {
+            consider({code_.tries[next_try_].last_address, 101, MethodItemKind::TRY_END, next_try_});
+        }
+        if (!found) {
+            return false;
+        }
+
+        switch (item.kind) {
+            case MethodItemKind::DEBUG: ++next_debug_; break;
+            case MethodItemKind::LABEL: next_label_ = labels_.next_address(next_label_ + 1); break;
+            case MethodItemKind::INSTRUCTION: ++next_instruction_; break;
+            case MethodItemKind::TRY_END: ++next_try_; break;
+        }
+        return true;
+    }
 
-void ClassDefinition::write_to(std::ostream& output) {
-    BaksmaliWriter writer(output, options_);
+private:
+    const DexCode& code_;
+    const MethodLabels& labels_;
+    const std::pmr::vector<MethodItemKey>& debug_keys_;
+    size_t next_debug_ = 0;
+    uint32_t next_label_;
+    uint32_t next_instruction_ = 0;
+    uint32_t next_try_ = 0;
+};
 
+} // namespace
+
+ClassDefinition::ClassDefinition(const DexClass& class_def, const DexFile& dex_file, const BaksmaliOptions& options,
+                                 std::pmr::memory_resource* resource)
+    : class_def_(class_def), dex_file_(dex_file), options_(options), resource_(resource), debug_items_(resource) {}
+
+void ClassDefinition::write_to(OutputBuffer& output) {
     write_class_header(output);
 
     if (!class_def_.static_fields.empty()) {
@@ -34,7 +187,7 @@ void ClassDefinition::write_to(std::ostream& output) {
     }
 }
 
-void ClassDefinition::write_class_header(std::ostream& output) {
+void ClassDefinition::write_class_header(OutputBuffer& output) {
     // Write class declaration
     output << ".class ";
 
@@ -76,7 +229,7 @@ void ClassDefinition::write_class_header(std::ostream& output) {
     write_annotations(output);
 }
 
-void ClassDefinition::write_annotations(std::ostream& output) {
+void ClassDefinition::write_annotations(OutputBuffer& output) {
     if (!class_def_.annotations.empty()) {
         output << "\n\n# annotations\n";
         for (const auto& annotation : class_def_.annotations) {
@@ -100,7 +253,7 @@ void ClassDefinition::write_annotations(std::ostream& output) {
     }
 }
 
-void ClassDefinition::write_static_fields(std::ostream& output) {
+void ClassDefinition::write_static_fields(OutputBuffer& output) {
     for (const auto& field : class_def_.static_fields) {
         output << ".field ";
 
@@ -132,7 +285,7 @@ void ClassDefinition::write_static_fields(std::ostream& output) {
     }
 }
 
-void ClassDefinition::write_instance_fields(std::ostream& output) {
+void ClassDefinition::write_instance_fields(OutputBuffer& output) {
     for (const auto& field : class_def_.instance_fields) {
         output << ".field ";
         
@@ -156,7 +309,7 @@ void ClassDefinition::write_instance_fields(std::ostream& output) {
     }
 }
 
-void ClassDefinition::write_direct_methods(std::ostream& output) {
+void ClassDefinition::write_direct_methods(OutputBuffer& output) {
     for (const auto& method : class_def_.direct_methods) {
         output << ".method ";
         
@@ -187,7 +340,7 @@ void ClassDefinition::write_direct_methods(std::ostream& output) {
     }
 }
 
-void ClassDefinition::write_virtual_methods(std::ostream& output) {
+void ClassDefinition::write_virtual_methods(OutputBuffer& output) {
     for (const auto& method : class_def_.virtual_methods) {
         output << ".method ";
         
@@ -216,7 +369,7 @@ void ClassDefinition::write_virtual_methods(std::ostream& output) {
     }
 }
 
-void ClassDefinition::write_field_annotations(std::ostream& output, const DexField& field) {
+void ClassDefinition::write_field_annotations(OutputBuffer& output, const DexField& field) {
     for (const auto& annotation : field.annotations) {
         output << "    .annotation system " << annotation.type << "\n";
         if (!annotation.elements.empty()) {
@@ -235,7 +388,7 @@ void ClassDefinition::write_field_annotations(std::ostream& output, const DexFie
     }
 }
 
-void ClassDefinition::write_method_annotations(std::ostream& output, const DexMethod& method) {
+void ClassDefinition::write_method_annotations(OutputBuffer& output, const DexMethod& method) {
     for (const auto& annotation : method.annotations) {
         output << "    .annotation system " << annotation.type << "\n";
         if (!annotation.elements.empty()) {
@@ -254,165 +407,106 @@ void ClassDefinition::write_method_annotations(std::ostream& output, const DexMe
     }
 }
 
-void ClassDefinition::write_method_code(std::ostream& output, const DexMethod& method) {
+void ClassDefinition::write_method_code(OutputBuffer& output, const DexMethod& method) {
     if (!method.code) {
         return;
     }
 
-    output << "    .registers " << method.code->registers_size << "\n";
+    const DexCode& code = *method.code;
+    output << "    .registers " << code.registers_size << "\n";
+
+    // Instructions are rendered here, straight into the class output
+    RegisterNaming registers;
+    registers.registers_size = code.registers_size;
+    registers.ins_size = code.ins_size;
+    registers.parameter_registers = options_.parameter_registers;
+    MethodLabels labels(code, options_.use_sequential_labels, resource_);
+
+    // Debug info is decoded here, per method, only when it will be written
+    std::pmr::vector<MethodItemKey> debug_keys(resource_);
+    debug_items_.clear();
+    if (options_.debug_info) {
+        dex_file_.decode_debug_info(method, debug_items_);
+        debug_keys = collect_debug_keys(debug_items_, resource_);
+    }
 
-    if (options_.debug_info && !method.code->debug_items.empty()) {
-        // Create a combined list of instructions and debug items with sort order
-        struct MethodItem {
-            uint32_t address;
-            int sort_order;
-            std::string text;
-            int register_num = -1;  // For END_LOCAL items, used for descending register order
-        };
-        std::vector<MethodItem> items;
-
-        // Add instructions (sort order 100, like Java baksmali)
-        const auto& instructions = method.code->instructions;
-        for (size_t i = 0; i < instructions.size(); ++i) {
-            const auto& instruction = instructions[i];
-            std::string formatted_instruction = DalvikInstructionParser::reformat_registers_for_method(
-                instruction.mnemonic, method.code->registers_size, method.code->ins_size);
-            items.push_back({instruction.address, 100, "    " + formatted_instruction});
-
-            // Add blank line after every instruction except the last one (matching Java baksmali BlankMethodItem behavior)
-            if (i != instructions.size() - 1) {
-                items.push_back({instruction.address, 101, ""});
-            }
+    // Each item is rendered as it is consumed. A blank line follows every
+    // instruction but the last, after its try end and before the next address.
+    MethodItemMerge items(code, labels, debug_keys);
+    MethodItemKey item;
+    const DexInstruction* blank_after = nullptr;
+    output << "\n";
+    while (items.next(item)) {
+        if (blank_after && item.address > blank_after->address) {
+            output << "\n";
+            blank_after = nullptr;
         }
-
-        // Add debug items with proper sort orders to match Java baksmali
-        for (const auto& debug_item : method.code->debug_items) {
-            std::ostringstream debug_line;
-            int sort_order = 0;
-
-            if (debug_item->type == DebugItem::START_LOCAL) {
-                auto* start_item = static_cast<StartLocalItem*>(debug_item.get());
-                std::string reg_name = DalvikInstructionParser::format_register(start_item->register_num, &method);
-                debug_line << "    .local " << reg_name;
-                if (!start_item->name.empty() || !start_item->type_descriptor.empty() || !start_item->signature.empty()) {
-                    debug_line << ", ";
-                    write_local_info_to_stream(debug_line, start_item->name, start_item->type_descriptor, start_item->signature);
+        switch (item.kind) {
+            case MethodItemKind::DEBUG:
+                write_debug_item(output, debug_items_[item.index], registers);
+                break;
+            case MethodItemKind::LABEL:
+                labels.write_labels_at(item.address, output);
+                break;
+            case MethodItemKind::INSTRUCTION:
+                write_instruction(output, code, code.instructions[item.index], dex_file_, registers, labels);
+                if (item.index + 1 != code.instructions.size()) {
+                    blank_after = &code.instructions[item.index];
                 }
-                sort_order = -1;
-            } else if (debug_item->type == DebugItem::END_LOCAL) {
-                auto* end_item = static_cast<EndLocalItem*>(debug_item.get());
-                std::string reg_name = DalvikInstructionParser::format_register(end_item->register_num, &method);
-                debug_line << "    .end local " << reg_name;
-                if (!end_item->name.empty() || !end_item->type_descriptor.empty() || !end_item->signature.empty()) {
-                    debug_line << "    # ";
-                    write_local_info_to_stream(debug_line, end_item->name, end_item->type_descriptor, end_item->signature);
-                }
-                sort_order = -1;
-            } else if (debug_item->type == DebugItem::LINE_NUMBER) {
-                auto* line_item = static_cast<LineNumberItem*>(debug_item.get());
-                // Normalize abnormal line numbers to reasonable values (max 10000)
-                uint32_t normalized_line = line_item->line_number;
-                if (normalized_line > 10000) {
-                    normalized_line = normalized_line % 1000 + 1;
-                }
-                debug_line << "    .line " << normalized_line;
-                sort_order = -2;
-            } else if (debug_item->type == DebugItem::RESTART_LOCAL) {
-                auto* restart_item = static_cast<RestartLocalItem*>(debug_item.get());
-                std::string reg_name = DalvikInstructionParser::format_register(restart_item->register_num, &method);
-                debug_line << "    .restart local " << reg_name;
-                if (!restart_item->name.empty() || !restart_item->type_descriptor.empty() || !restart_item->signature.empty()) {
-                    debug_line << ", ";
-                    write_local_info_to_stream(debug_line, restart_item->name, restart_item->type_descriptor, restart_item->signature);
-                }
-                sort_order = -1;
-            } else if (debug_item->type == DebugItem::PROLOGUE_END) {
-                debug_line << "    .prologue";
-                sort_order = -4;
-            } else if (debug_item->type == DebugItem::EPILOGUE_BEGIN) {
-                debug_line << "    .epilogue";
-                sort_order = -4;
-            } else if (debug_item->type == DebugItem::SET_SOURCE_FILE) {
-                auto* source_item = static_cast<SetSourceFileItem*>(debug_item.get());
-                debug_line << "    .source \"" << source_item->source_file << "\"";
-                sort_order = -3;
-            }
-
-            // Store register number for END_LOCAL items to enable proper sorting
-            int reg_num = (debug_item->type == DebugItem::END_LOCAL) ?
-                         static_cast<EndLocalItem*>(debug_item.get())->register_num : -1;
-            items.push_back({debug_item->address, sort_order, debug_line.str(), reg_num});
-        }
-
-        // Sort by address first, then by sort order, then by register order for END_LOCAL (matching Java baksmali behavior)
-        std::sort(items.begin(), items.end(), [&](const MethodItem& a, const MethodItem& b) {
-            if (a.address != b.address) {
-                return a.address < b.address;
-            }
-            if (a.sort_order != b.sort_order) {
-                return a.sort_order < b.sort_order;
-            }
-            // For END_LOCAL items with same address and sort_order, sort by ascending register number
-            if (a.sort_order == -1 && a.register_num != -1 && b.register_num != -1) {
-                return a.register_num < b.register_num;  // Ascending order
-            }
-            return false;  // Maintain stable order for other items
-        });
-
-        // Output the combined items
-        output << "\n";
-        for (const auto& item : items) {
-            output << item.text << "\n";
+                break;
+            case MethodItemKind::TRY_END:
+                write_try_end(output, code, code.tries[item.index], dex_file_, labels);
+                break;
         }
-    } else {
-        // Simple output without debug info - match Java baksmali spacing behavior
+    }
+    if (blank_after) {
         output << "\n";
-        const auto& instructions = method.code->instructions;
-        for (size_t i = 0; i < instructions.size(); ++i) {
-            std::string formatted_instruction = DalvikInstructionParser::reformat_registers_for_method(
-                instructions[i].mnemonic, method.code->registers_size, method.code->ins_size);
-            output << "    " << formatted_instruction << "\n";
-
-            // Add blank line after every instruction except the last one (matching Java baksmali behavior)
-            if (i != instructions.size() - 1) {
-                output << "\n";
-            }
-        }
     }
 }
 
-void ClassDefinition::write_debug_items(std::ostream& output, const std::vector<std::unique_ptr<DebugItem>>& debug_items) {
-    for (const auto& debug_item : debug_items) {
-        if (debug_item->type == DebugItem::START_LOCAL) {
-            auto* start_item = static_cast<StartLocalItem*>(debug_item.get());
-            output << "    .local v" << start_item->register_num;
-            if (!start_item->name.empty() || !start_item->type_descriptor.empty() || !start_item->signature.empty()) {
-                output << ", ";
-                write_local_info(output, start_item->name, start_item->type_descriptor, start_item->signature);
+void ClassDefinition::write_debug_item(OutputBuffer& output, const DebugItem& debug_item, const RegisterNaming& registers) {
+    switch (debug_item.type) {
+        case DebugItem::START_LOCAL:
+        case DebugItem::RESTART_LOCAL:
+        case DebugItem::END_LOCAL: {
+            if (debug_item.type == DebugItem::START_LOCAL) {
+                output << "    .local ";
+            } else if (debug_item.type == DebugItem::RESTART_LOCAL) {
+                output << "    .restart local ";
+            } else {
+                output << "    .end local ";
             }
-            output << "\n";
-        } else if (debug_item->type == DebugItem::END_LOCAL) {
-            auto* end_item = static_cast<EndLocalItem*>(debug_item.get());
-            output << "    .end local v" << end_item->register_num;
-            if (!end_item->name.empty() || !end_item->type_descriptor.empty() || !end_item->signature.empty()) {
-                output << "    # ";
-                write_local_info(output, end_item->name, end_item->type_descriptor, end_item->signature);
+            DalvikInstructionParser::append_register(debug_item.register_num, registers, output);
+
+            // Names are resolved from their ids only now, as they are written
+            std::string_view name = debug_item.name_idx == DebugItem::THIS_NAME ?
+                                    std::string_view("this") : std::string_view(dex_file_.get_string(debug_item.name_idx));
+            std::string_view type = dex_file_.get_type_name(debug_item.type_idx);
+            std::string_view signature = dex_file_.get_string(debug_item.signature_idx);
+            if (!name.empty() || !type.empty() || !signature.empty()) {
+                output << (debug_item.type == DebugItem::END_LOCAL ? "    # " : ", ");
+                write_local_info(output, name, type, signature);
             }
-            output << "\n";
-        } else if (debug_item->type == DebugItem::LINE_NUMBER) {
-            auto* line_item = static_cast<LineNumberItem*>(debug_item.get());
-            output << "    .line " << line_item->line_number << "\n";
+            break;
         }
+        case DebugItem::LINE_NUMBER:
+            output << "    .line " << debug_item.line_number;
+            break;
+        case DebugItem::PROLOGUE_END:
+            output << "    .prologue";
+            break;
+        case DebugItem::EPILOGUE_BEGIN:
+            output << "    .epilogue";
+            break;
+        case DebugItem::SET_SOURCE_FILE:
+            output << "    .source \"" << dex_file_.get_string(debug_item.name_idx) << "\"";
+            break;
     }
+    output << "\n";
 }
 
-void ClassDefinition::write_local_info(std::ostream& output, const std::string& name,
-                                       const std::string& type, const std::string& signature) {
-    write_local_info_to_stream(output, name, type, signature);
-}
-
-void ClassDefinition::write_local_info_to_stream(std::ostream& output, const std::string& name,
-                                                  const std::string& type, const std::string& signature) {
+void ClassDefinition::write_local_info(OutputBuffer& output, std::string_view name,
+                                       std::string_view type, std::string_view signature) {
     if (!name.empty()) {
         output << "\"" << name << "\"";
     } else {
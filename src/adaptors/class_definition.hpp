@@ -2,30 +2,36 @@
 
 #include "../dex/dex_structures.hpp"
 #include "../baksmali_options.hpp"
-#include <ostream>
+#include "../formatter/output_buffer.hpp"
+
+class DexFile;
 
 class ClassDefinition {
 public:
-    ClassDefinition(const DexClass& class_def, const BaksmaliOptions& options);
+    // Per-method scratch (labels, debug events) comes from `resource`
+    ClassDefinition(const DexClass& class_def, const DexFile& dex_file, const BaksmaliOptions& options,
+                    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     
-    void write_to(std::ostream& output);
+    // Renders the whole class, instructions included, into `output`
+    void write_to(OutputBuffer& output);
     
 private:
     const DexClass& class_def_;
+    const DexFile& dex_file_;
     const BaksmaliOptions& options_;
+    std::pmr::memory_resource* resource_;
+    std::pmr::vector<DebugItem> debug_items_;  // Current method's debug events, reused across methods
     
-    void write_class_header(std::ostream& output);
-    void write_annotations(std::ostream& output);
-    void write_static_fields(std::ostream& output);
-    void write_instance_fields(std::ostream& output);
-    void write_direct_methods(std::ostream& output);
-    void write_virtual_methods(std::ostream& output);
-    void write_field_annotations(std::ostream& output, const DexField& field);
-    void write_method_annotations(std::ostream& output, const DexMethod& method);
-    void write_method_code(std::ostream& output, const DexMethod& method);
-    void write_debug_items(std::ostream& output, const std::vector<std::unique_ptr<DebugItem>>& debug_items);
-    void write_local_info(std::ostream& output, const std::string& name,
-                          const std::string& type, const std::string& signature);
-    void write_local_info_to_stream(std::ostream& output, const std::string& name,
-                                    const std::string& type, const std::string& signature);
+    void write_class_header(OutputBuffer& output);
+    void write_annotations(OutputBuffer& output);
+    void write_static_fields(OutputBuffer& output);
+    void write_instance_fields(OutputBuffer& output);
+    void write_direct_methods(OutputBuffer& output);
+    void write_virtual_methods(OutputBuffer& output);
+    void write_field_annotations(OutputBuffer& output, const DexField& field);
+    void write_method_annotations(OutputBuffer& output, const DexMethod& method);
+    void write_method_code(OutputBuffer& output, const DexMethod& method);
+    void write_debug_item(OutputBuffer& output, const DebugItem& debug_item, const struct RegisterNaming& registers);
+    void write_local_info(OutputBuffer& output, std::string_view name,
+                          std::string_view type, std::string_view signature);
 };
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include "baksmali.hpp"
+#include "class_scheduler.hpp"
+#include "memory_window.hpp"
 #include "formatter/baksmali_writer.hpp"
 #include "adaptors/class_definition.hpp"
+#include "dex/zip_archive.hpp"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 #include <thread>
+#include <atomic>
+#include <chrono>
 #include <algorithm>
 #include <cctype>
 #include <unordered_map>
@@ -12,7 +17,17 @@
 Baksmali::Baksmali(const BaksmaliOptions& options) : options_(options) {}
 
 bool Baksmali::disassemble() {
-    if (!load_dex_file()) {
+    std::shared_ptr<const MappedFile> input = MappedFile::open(options_.input_file);
+    if (!input) {
+        std::cerr << "Error: Failed to load input file: " << options_.input_file << std::endl;
+        return false;
+    }
+    
+    if (ZipArchive::is_zip(input->view())) {
+        return disassemble_archive(std::move(input));
+    }
+    
+    if (!load_dex_file(std::move(input))) {
         return false;
     }
     
@@ -20,42 +35,165 @@ bool Baksmali::disassemble() {
         return false;
     }
     
+    bool success = disassemble_dex_file();
+    report_unmatched_class_filters();
+    return success;
+}
+
+bool Baksmali::disassemble_archive(std::shared_ptr<const MappedFile> input) {
+    auto archive = ZipArchive::open(std::move(input));
+    if (!archive) {
+        std::cerr << "Error: Failed to read archive: " << options_.input_file << std::endl;
+        return false;
+    }
+    
+    auto dex_entries = archive->dex_entries();
+    if (dex_entries.empty()) {
+        std::cerr << "Error: No classes*.dex entries found in " << options_.input_file << std::endl;
+        return false;
+    }
+    
+    if (!create_output_directory()) {
+        return false;
+    }
+    
+    // Entries are handled one at a time so only a single DEX is resident at once
+    bool success = true;
+    for (const ZipEntry* entry : dex_entries) {
+        std::vector<uint8_t> inflated;
+        auto data = archive->read_entry(*entry, inflated);
+        if (!data) {
+            success = false;
+            continue;
+        }
+        
+        if (inflated.empty()) {
+            dex_file_ = DexFile::open(archive->file(), *data);
+        } else {
+            dex_file_ = DexFile::open(std::move(inflated));
+        }
+        
+        if (!dex_file_) {
+            std::cerr << "Error: Failed to load DEX entry: " << entry->name << std::endl;
+            success = false;
+            continue;
+        }
+        
+        if (options_.verbose) {
+            std::cout << "Loaded " << entry->name << " with " << dex_file_->class_count() << " classes" << std::endl;
+        }
+        
+        if (!disassemble_dex_file()) {
+            success = false;
+        }
+        dex_file_.reset();
+    }
+    
+    report_unmatched_class_filters();
+    return success;
+}
+
+bool Baksmali::disassemble_dex_file() {
+    // Parts of the file the output will not contain are never decoded
+    DexDecodeFeatures features;
+    features.debug_info = options_.debug_info;
+    dex_file_->set_decode_features(features);
+    
+    std::vector<uint32_t> class_indices = select_classes();
+    size_t class_count = class_indices.size();
     if (options_.verbose) {
-        std::cout << "Disassembling " << dex_file_->classes().size() << " classes..." << std::endl;
+        std::cout << "Disassembling " << class_count << " classes..." << std::endl;
     }
     
+    auto start = std::chrono::steady_clock::now();
+    
+    bool success = true;
     // Use parallel processing if multiple jobs are requested
     if (options_.job_count != 1) {
-        auto futures = disassemble_classes_parallel();
-        
-        bool success = true;
-        for (auto& future : futures) {
-            if (!future.get()) {
-                success = false;
-            }
-        }
-        return success;
+        success = disassemble_classes_parallel(class_indices);
     } else {
-        // Single-threaded processing
-        bool success = true;
-        for (const auto& class_def : dex_file_->classes()) {
-            if (!disassemble_class(class_def)) {
+        // Single-threaded processing; only one class is ever held
+        OutputBuffer buffer;
+        ClassArena arena;
+        for (uint32_t class_index : class_indices) {
+            if (!disassemble_class(class_index, buffer, arena)) {
                 success = false;
             }
+            arena.release();
+            if (options_.memory_budget != 0 && buffer.capacity() > options_.memory_budget) {
+                buffer.release();
+            }
+        }
+    }
+    
+    if (options_.verbose) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double seconds = elapsed.count();
+        std::cout << "Disassembled " << class_count << " classes in " << seconds << "s";
+        if (seconds > 0) {
+            std::cout << " (" << static_cast<uint64_t>(class_count / seconds) << " classes/s)";
+        }
+        std::cout << std::endl;
+        
+        auto cache = dex_file_->reference_cache_stats();
+        std::cout << "Reference cache: methods " << cache.methods.hits << " hits / " << cache.methods.misses
+                  << " misses, fields " << cache.fields.hits << " hits / " << cache.fields.misses
+                  << " misses, string literals " << cache.literals.hits << " hits / " << cache.literals.misses
+                  << " misses" << std::endl;
+    }
+    
+    return success;
+}
+
+std::vector<uint32_t> Baksmali::select_classes() {
+    std::vector<uint32_t> class_indices;
+    
+    if (options_.classes.empty()) {
+        class_indices.resize(dex_file_->class_count());
+        for (uint32_t i = 0; i < dex_file_->class_count(); ++i) {
+            class_indices[i] = i;
+        }
+        return class_indices;
+    }
+    
+    // Exact descriptors are looked up directly; a trailing '*' selects every descriptor with that prefix
+    class_filter_matched_.resize(options_.classes.size(), false);
+    for (size_t i = 0; i < options_.classes.size(); ++i) {
+        const std::string& pattern = options_.classes[i];
+        if (!pattern.empty() && pattern.back() == '*') {
+            auto matches = dex_file_->find_classes_with_prefix(std::string_view(pattern).substr(0, pattern.size() - 1));
+            class_indices.insert(class_indices.end(), matches.begin(), matches.end());
+            class_filter_matched_[i] = class_filter_matched_[i] || !matches.empty();
+        } else if (auto match = dex_file_->find_class(pattern)) {
+            class_indices.push_back(*match);
+            class_filter_matched_[i] = true;
+        }
+    }
+    
+    // Keep DEX order and drop classes selected by more than one pattern
+    std::sort(class_indices.begin(), class_indices.end());
+    class_indices.erase(std::unique(class_indices.begin(), class_indices.end()), class_indices.end());
+    return class_indices;
+}
+
+void Baksmali::report_unmatched_class_filters() const {
+    for (size_t i = 0; i < class_filter_matched_.size(); ++i) {
+        if (!class_filter_matched_[i]) {
+            std::cerr << "Warning: No class matches " << options_.classes[i] << std::endl;
         }
-        return success;
     }
 }
 
-bool Baksmali::load_dex_file() {
-    dex_file_ = DexFile::open(options_.input_file);
+bool Baksmali::load_dex_file(std::shared_ptr<const MappedFile> input) {
+    ByteView data = input->view();
+    dex_file_ = DexFile::open(std::move(input), data);
     if (!dex_file_) {
         std::cerr << "Error: Failed to load DEX file: " << options_.input_file << std::endl;
         return false;
     }
     
     if (options_.verbose) {
-        std::cout << "Loaded DEX file with " << dex_file_->classes().size() << " classes" << std::endl;
+        std::cout << "Loaded DEX file with " << dex_file_->class_count() << " classes" << std::endl;
     }
     
     return true;
@@ -71,34 +209,116 @@ bool Baksmali::create_output_directory() {
     }
 }
 
-std::vector<std::future<bool>> Baksmali::disassemble_classes_parallel() {
-    std::vector<std::future<bool>> futures;
+unsigned int Baksmali::resolve_job_count() const {
+    if (options_.job_count > 0) {
+        return static_cast<unsigned int>(options_.job_count);
+    }
     
-    // Determine number of threads
-    int job_count = options_.job_count;
-    if (job_count <= 0) {
-        job_count = std::thread::hardware_concurrency();
-        if (job_count <= 0) {
-            job_count = 4; // fallback
-        }
+    unsigned int job_count = std::thread::hardware_concurrency();
+    if (job_count == 0) {
+        job_count = 4; // fallback
     }
+    return job_count;
+}
+
+namespace {
+
+// Rough relative cost of writing a class: every class pays for a file, every
+// member for its header lines, and methods scale with their code size.
+uint64_t estimate_class_cost(const DexClassSummary& summary) {
+    constexpr uint64_t CLASS_COST = 64;
+    constexpr uint64_t MEMBER_COST = 8;
+
+    return CLASS_COST + MEMBER_COST * (summary.field_count + summary.method_count) + summary.insns_size;
+}
+
+// Rough peak bytes a class holds while it is written: its parsed form in the
+// arena and its rendered text both grow with the member count and code size.
+uint64_t estimate_class_footprint(const DexClassSummary& summary) {
+    constexpr uint64_t CLASS_BYTES = 4096;
+    constexpr uint64_t MEMBER_BYTES = 256;
+    constexpr uint64_t CODE_UNIT_BYTES = 48;
+
+    return CLASS_BYTES + MEMBER_BYTES * (summary.field_count + summary.method_count) + CODE_UNIT_BYTES * summary.insns_size;
+}
+
+} // namespace
+
+bool Baksmali::disassemble_classes_parallel(const std::vector<uint32_t>& class_indices) {
+    size_t class_count = class_indices.size();
+    if (class_count == 0) {
+        return true;
+    }
+    
+    // Fixed-size pool; never start more workers than there are classes
+    size_t worker_count = std::min<size_t>(resolve_job_count(), class_count);
+    if (options_.verbose) {
+        std::cout << "Using " << worker_count << " worker threads" << std::endl;
+    }
+    
+    std::vector<uint64_t> costs;
+    std::vector<uint64_t> footprints;
+    costs.reserve(class_count);
+    footprints.reserve(class_count);
+    for (uint32_t class_index : class_indices) {
+        DexClassSummary summary = dex_file_->summarize_class(class_index);
+        costs.push_back(estimate_class_cost(summary));
+        footprints.push_back(estimate_class_footprint(summary));
+    }
+    
+    ClassScheduler scheduler(costs, worker_count);
+    MemoryWindow window(options_.memory_budget);
+    // A worker gives back a buffer that outgrew its share of the budget
+    uint64_t retained_limit = options_.memory_budget / worker_count;
+    std::atomic<bool> success{true};
+    
+    auto worker = [this, &class_indices, &footprints, &scheduler, &window, retained_limit, &success](size_t worker_index) {
+        // Reused for every class this worker writes
+        OutputBuffer buffer;
+        ClassArena arena;
+        while (auto index = scheduler.next(worker_index)) {
+            // Decoded, rendered, written and freed inside the window
+            window.acquire(footprints[*index]);
+            if (!disassemble_class(class_indices[*index], buffer, arena)) {
+                success.store(false, std::memory_order_relaxed);
+            }
+            arena.release();
+            if (retained_limit != 0 && buffer.capacity() > retained_limit) {
+                buffer.release();
+            }
+            window.release(footprints[*index]);
+        }
+    };
     
-    // Create thread pool using std::async
-    const auto& classes = dex_file_->classes();
-    futures.reserve(classes.size());
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(worker, i);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
     
-    for (const auto& class_def : classes) {
-        futures.emplace_back(
-            std::async(std::launch::async, [this, &class_def]() {
-                return disassemble_class(class_def);
-            })
-        );
+    if (options_.verbose) {
+        std::cout << "Work stealing moved " << scheduler.steal_count() << " classes between workers" << std::endl;
+        if (window.budget() != 0) {
+            std::cout << "Memory window: peak " << window.peak() << " of " << window.budget()
+                      << " bytes in flight, " << window.wait_count() << " classes waited" << std::endl;
+        }
     }
     
-    return futures;
+    return success.load();
 }
 
-bool Baksmali::disassemble_class(const DexClass& class_def) {
+bool Baksmali::disassemble_class(uint32_t class_index, OutputBuffer& buffer, ClassArena& arena) {
+    // Parsed in the calling worker's arena and dropped as soon as the file is written
+    ArenaPtr<DexClass> dex_class = dex_file_->load_class(class_index, arena.resource());
+    if (!dex_class) {
+        std::cerr << "Error: Failed to parse class " << dex_file_->class_descriptor(class_index) << std::endl;
+        return false;
+    }
+    const DexClass& class_def = *dex_class;
+    
     try {
         std::string output_filename = get_unique_output_filename(class_def.class_name);
         std::string full_path = options_.output_directory + "/" + output_filename;
@@ -106,14 +326,17 @@ bool Baksmali::disassemble_class(const DexClass& class_def) {
         // Create parent directories if needed
         std::filesystem::create_directories(std::filesystem::path(full_path).parent_path());
         
-        std::ofstream output(full_path);
+        // Render the whole class first, then write it out in one go
+        buffer.clear();
+        ClassDefinition class_adapter(class_def, *dex_file_, options_, arena.resource());
+        class_adapter.write_to(buffer);
+        
+        std::ofstream output(full_path, std::ios::binary);
         if (!output.is_open()) {
             std::cerr << "Error: Cannot create output file: " << full_path << std::endl;
             return false;
         }
-        
-        ClassDefinition class_adapter(class_def, options_);
-        class_adapter.write_to(output);
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
         
         if (options_.verbose) {
             std::cout << "Generated: " << output_filename << std::endl;
@@ -126,8 +349,8 @@ bool Baksmali::disassemble_class(const DexClass& class_def) {
     }
 }
 
-std::string Baksmali::get_output_filename(const std::string& class_descriptor) {
-    std::string filename = class_descriptor;
+std::string Baksmali::get_output_filename(std::string_view class_descriptor) {
+    std::string filename(class_descriptor);
 
     // Remove leading 'L' and trailing ';' if present
     if (filename.length() > 2 && filename[0] == 'L' && filename.back() == ';') {
@@ -143,7 +366,7 @@ std::string Baksmali::get_output_filename(const std::string& class_descriptor) {
     return filename;
 }
 
-std::string Baksmali::get_unique_output_filename(const std::string& class_descriptor) {
+std::string Baksmali::get_unique_output_filename(std::string_view class_descriptor) {
     std::string base_filename = get_output_filename(class_descriptor);
 
     // Check for collision using case-insensitive comparison for filesystem safety
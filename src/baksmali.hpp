@@ -2,9 +2,10 @@
 
 #include "baksmali_options.hpp"
 #include "dex/dex_file.hpp"
+#include "dex/class_arena.hpp"
+#include "formatter/output_buffer.hpp"
 #include <memory>
 #include <vector>
-#include <future>
 #include <unordered_map>
 #include <string>
 #include <mutex>
@@ -20,11 +21,18 @@ private:
     std::unique_ptr<DexFile> dex_file_;
     std::unordered_map<std::string, int> filename_counters_;
     std::mutex filename_mutex_;
+    std::vector<bool> class_filter_matched_;  // Parallel to options_.classes, across all DEX files
 
-    bool load_dex_file();
+    bool load_dex_file(std::shared_ptr<const MappedFile> input);
+    bool disassemble_archive(std::shared_ptr<const MappedFile> input);
+    bool disassemble_dex_file();
     bool create_output_directory();
-    std::vector<std::future<bool>> disassemble_classes_parallel();
-    bool disassemble_class(const DexClass& class_def);
-    std::string get_output_filename(const std::string& class_descriptor);
-    std::string get_unique_output_filename(const std::string& class_descriptor);
+    std::vector<uint32_t> select_classes();
+    void report_unmatched_class_filters() const;
+    bool disassemble_classes_parallel(const std::vector<uint32_t>& class_indices);
+    unsigned int resolve_job_count() const;
+    // The class is parsed into `arena`; the caller releases it afterwards
+    bool disassemble_class(uint32_t class_index, OutputBuffer& buffer, ClassArena& arena);
+    std::string get_output_filename(std::string_view class_descriptor);
+    std::string get_unique_output_filename(std::string_view class_descriptor);
 };
\ No newline at end of file
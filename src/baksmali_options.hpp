@@ -13,6 +13,8 @@ struct BaksmaliOptions {
     
     // Threading
     int job_count = 0; // 0 = auto-detect
+    // Estimated bytes of classes held across all workers at once; 0 = unbounded
+    uint64_t memory_budget = 0;
     
     // Formatting options
     bool debug_info = true;
@@ -29,7 +31,7 @@ struct BaksmaliOptions {
     // Output options
     bool use_sequential_labels = false;
     
-    // Class filtering
+    // Class filtering: exact descriptors, or prefixes ending in '*'. Empty = all classes.
     std::vector<std::string> classes;
     
     // Verbose output
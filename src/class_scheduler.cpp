@@ -0,0 +1,97 @@
+#include "class_scheduler.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
+
+ClassScheduler::ClassScheduler(const std::vector<uint64_t>& costs, size_t worker_count)
+    : costs_(costs) {
+    worker_count = std::max<size_t>(worker_count, 1);
+    queues_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    // Largest first; ties keep DEX order so runs are reproducible
+    std::vector<size_t> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) {
+        return costs[a] > costs[b];
+    });
+
+    // Min-heap of (queued cost, worker)
+    using Load = std::pair<uint64_t, size_t>;
+    std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+    for (size_t i = 0; i < worker_count; ++i) {
+        loads.emplace(0, i);
+    }
+
+    for (size_t index : order) {
+        Load least = loads.top();
+        loads.pop();
+
+        WorkerQueue& queue = *queues_[least.second];
+        queue.classes.push_back(index);
+        queue.remaining_cost += costs[index];
+
+        least.first += costs[index];
+        loads.push(least);
+    }
+}
+
+std::optional<size_t> ClassScheduler::next(size_t worker) {
+    WorkerQueue& own = *queues_[worker];
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.classes.empty()) {
+            size_t index = own.classes.front();
+            own.classes.pop_front();
+            own.remaining_cost -= costs_[index];
+            return index;
+        }
+    }
+    return steal(worker);
+}
+
+std::optional<size_t> ClassScheduler::steal(size_t thief) {
+    // Retry until a steal succeeds or every queue is observed empty
+    for (;;) {
+        size_t victim = queues_.size();
+        uint64_t victim_cost = 0;
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            if (i == thief) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(queues_[i]->mutex);
+            if (!queues_[i]->classes.empty() && (victim == queues_.size() || queues_[i]->remaining_cost > victim_cost)) {
+                victim = i;
+                victim_cost = queues_[i]->remaining_cost;
+            }
+        }
+
+        if (victim == queues_.size()) {
+            return std::nullopt;
+        }
+
+        WorkerQueue& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.classes.empty()) {
+            continue; // Drained while we were looking; pick another victim
+        }
+
+        size_t index = queue.classes.back();
+        queue.classes.pop_back();
+        queue.remaining_cost -= costs_[index];
+
+        queues_[thief]->steals.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+}
+
+uint64_t ClassScheduler::steal_count() const {
+    uint64_t total = 0;
+    for (const auto& queue : queues_) {
+        total += queue->steals.load(std::memory_order_relaxed);
+    }
+    return total;
+}
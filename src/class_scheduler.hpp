@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Distributes class indices across a fixed set of workers.
+//
+// Classes are assigned longest-processing-time first: sorted by estimated
+// cost, each one goes to the worker with the least work queued so far.
+// Each worker drains its own deque from the front (largest first); a worker
+// that runs dry steals from the back (smallest) of the busiest other deque,
+// which evens out mistakes in the cost estimate.
+class ClassScheduler {
+public:
+    ClassScheduler(const std::vector<uint64_t>& costs, size_t worker_count);
+
+    ClassScheduler(const ClassScheduler&) = delete;
+    ClassScheduler& operator=(const ClassScheduler&) = delete;
+
+    // Next class index for `worker`, or nullopt once every queue is empty
+    std::optional<size_t> next(size_t worker);
+
+    size_t worker_count() const { return queues_.size(); }
+    uint64_t steal_count() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> classes;
+        uint64_t remaining_cost = 0;
+        std::atomic<uint64_t> steals{0};
+    };
+
+    std::optional<size_t> steal(size_t thief);
+
+    const std::vector<uint64_t>& costs_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+};
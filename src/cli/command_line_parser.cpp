@@ -1,5 +1,7 @@
 #include "command_line_parser.hpp"
 #include <iostream>
+#include <charconv>
+#include <cstdint>
 #include <cstring>
 #include <filesystem>
 
@@ -38,6 +40,21 @@ std::optional<BaksmaliOptions> CommandLineParser::parse(int argc, char* argv[])
                 return std::nullopt;
             }
             options.job_count = std::stoi(argv[++i]);
+        } else if (arg == "--memory-budget") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires a value" << std::endl;
+                return std::nullopt;
+            }
+            // Given in megabytes; negative, malformed and overflowing sizes are rejected
+            std::string value = argv[++i];
+            constexpr uint64_t MEGABYTE = 1024 * 1024;
+            uint64_t megabytes = 0;
+            auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), megabytes);
+            if (error != std::errc() || end != value.data() + value.size() || megabytes > UINT64_MAX / MEGABYTE) {
+                std::cerr << "Error: " << arg << " requires a size in megabytes, got " << value << std::endl;
+                return std::nullopt;
+            }
+            options.memory_budget = megabytes * MEGABYTE;
         } else if (arg == "--debug-info") {
             if (i + 1 >= argc) {
                 std::cerr << "Error: " << arg << " requires a value" << std::endl;
@@ -62,6 +79,24 @@ std::optional<BaksmaliOptions> CommandLineParser::parse(int argc, char* argv[])
                 return std::nullopt;
             }
             options.code_offsets = (std::string(argv[++i]) == "true");
+        } else if (arg == "--classes") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires a value" << std::endl;
+                return std::nullopt;
+            }
+            // Comma-separated; the option may also be repeated
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t comma = list.find(',', start);
+                if (comma == std::string::npos) {
+                    comma = list.size();
+                }
+                if (comma > start) {
+                    options.classes.push_back(list.substr(start, comma - start));
+                }
+                start = comma + 1;
+            }
         } else if (arg == "--sequential-labels") {
             options.use_sequential_labels = true;
         } else if (arg == "--verbose") {
@@ -95,17 +130,20 @@ std::optional<BaksmaliOptions> CommandLineParser::parse(int argc, char* argv[])
 
 void CommandLineParser::print_help() {
     std::cout << "baksmali_cpp - A C++ implementation of baksmali\n\n";
-    std::cout << "Usage: baksmali [options] <dex-file>\n\n";
+    std::cout << "Usage: baksmali [options] <dex-file | apk/jar/zip>\n\n";
     std::cout << "Options:\n";
     std::cout << "  -h, --help              Show this help message\n";
     std::cout << "  -v, --version           Show version information\n";
     std::cout << "  -o, --output <dir>      Output directory (default: out)\n";
     std::cout << "  --api-level <level>     API level (default: 15)\n";
     std::cout << "  -j, --jobs <count>      Number of threads (default: auto)\n";
+    std::cout << "  --memory-budget <MB>    Cap on classes held in memory at once (default: unbounded)\n";
     std::cout << "  --debug-info <bool>     Include debug info (default: true)\n";
     std::cout << "  --register-info <bool>  Include register info (default: false)\n";
     std::cout << "  --parameter-registers <bool> Use parameter registers (default: true)\n";
     std::cout << "  --code-offsets <bool>   Include code offsets (default: false)\n";
+    std::cout << "  --classes <list>        Only disassemble these classes; comma-separated descriptors,\n";
+    std::cout << "                          a trailing * matches a prefix (e.g. Lcom/example/*)\n";
     std::cout << "  --sequential-labels     Use sequential labels instead of addresses\n";
     std::cout << "  --verbose               Verbose output\n";
 }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+// Destroys an object made by arena_new and hands its block back to the
+// resource it came from (a no-op for a monotonic arena)
+template <typename T>
+struct ArenaDelete {
+    std::pmr::memory_resource* resource = nullptr;
+
+    void operator()(T* object) const {
+        object->~T();
+        resource->deallocate(object, sizeof(T), alignof(T));
+    }
+};
+
+template <typename T>
+using ArenaPtr = std::unique_ptr<T, ArenaDelete<T>>;
+
+template <typename T, typename... Args>
+ArenaPtr<T> arena_new(std::pmr::memory_resource* resource, Args&&... args) {
+    void* memory = resource->allocate(sizeof(T), alignof(T));
+    try {
+        return ArenaPtr<T>(new (memory) T(std::forward<Args>(args)...), ArenaDelete<T>{resource});
+    } catch (...) {
+        resource->deallocate(memory, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
+// Scratch memory for one class at a time.
+//
+// A loaded class and everything it owns (members, code, annotations, label
+// bitmaps) is carved out of this arena by bumping a pointer, and the whole
+// graph is dropped at once by release() after the class is written. Each
+// worker owns one, so parsing never takes the global allocator's locks. The
+// first block is kept across releases; a class that outgrows it spills into
+// blocks from the heap that are freed on the next release.
+class ClassArena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    explicit ClassArena(size_t block_size = DEFAULT_BLOCK_SIZE)
+        : block_(std::make_unique<std::byte[]>(block_size)),
+          resource_(block_.get(), block_size, std::pmr::new_delete_resource()) {}
+
+    ClassArena(const ClassArena&) = delete;
+    ClassArena& operator=(const ClassArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+
+    // Everything allocated from the arena must already be destroyed
+    void release() { resource_.release(); }
+
+private:
+    std::unique_ptr<std::byte[]> block_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
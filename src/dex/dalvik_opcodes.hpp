@@ -1,8 +1,12 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <cstdint>
+#include "opcode_table.hpp"
+#include "../formatter/output_buffer.hpp"
+
+class MethodLabels;
 
 // Dalvik opcodes (from AOSP)
 enum DalvikOpcode : uint8_t {
@@ -176,21 +180,46 @@ enum DalvikOpcode : uint8_t {
     OP_DIV_INT_LIT8 = 0xdb, OP_REM_INT_LIT8 = 0xdc, OP_AND_INT_LIT8 = 0xdd,
     OP_OR_INT_LIT8 = 0xde, OP_XOR_INT_LIT8 = 0xdf, OP_SHL_INT_LIT8 = 0xe0,
     OP_SHR_INT_LIT8 = 0xe1, OP_USHR_INT_LIT8 = 0xe2,
+    
+    // Method handles and call sites (API 26+)
+    OP_INVOKE_POLYMORPHIC = 0xfa, OP_INVOKE_POLYMORPHIC_RANGE = 0xfb,
+    OP_INVOKE_CUSTOM = 0xfc, OP_INVOKE_CUSTOM_RANGE = 0xfd,
+    OP_CONST_METHOD_HANDLE = 0xfe, OP_CONST_METHOD_TYPE = 0xff,
+};
+
+// How register operands are named in one method: the last ins_size registers
+// are the parameters and print as p0, p1, ... when parameter_registers is set.
+struct RegisterNaming {
+    uint32_t registers_size = 0;
+    uint32_t ins_size = 0;
+    bool parameter_registers = true;
 };
 
 class DalvikInstructionParser {
 public:
     static std::string get_opcode_name(uint8_t opcode);
     static int get_instruction_width(uint8_t opcode);
-    static std::string format_instruction(const uint16_t* insn, uint32_t address, const class DexFile* dex_file);
-    static std::string format_instruction_with_method(const uint16_t* insn, uint32_t address, const class DexFile* dex_file, const struct DexMethod* method);
-    static std::string reformat_registers_for_method(const std::string& instruction, uint16_t registers_size, uint16_t ins_size);
+    // Code units taken by the instruction or payload at `address`
+    static uint32_t instruction_width(const uint16_t* insns, uint32_t insns_size, uint32_t address);
+    // Decodes the instruction at `address` (in code units) of a method's code
+    static void decode_instruction(const uint16_t* insns, uint32_t insns_size, uint32_t address,
+                                   struct DexInstruction& out);
 
-    // Helper functions for register formatting (public for use by adaptors)
-    static std::string format_register(uint8_t reg, const struct DexMethod* method);
-    static bool is_parameter_register(uint8_t reg, const struct DexMethod* method);
+    static std::string format_instruction(const struct DexInstruction& insn, const class DexFile* dex_file,
+                                          const RegisterNaming& registers = {});
 
-private:
-    static const std::unordered_map<uint8_t, std::string> opcode_names_;
-    static const std::unordered_map<uint8_t, int> instruction_widths_;
-};
\ No newline at end of file
+    // Allocation-free variants that append to `out`. Branch targets are named
+    // through `labels` when given, otherwise after their code-unit address.
+    static void append_opcode_name(uint8_t opcode, OutputBuffer& out);
+    static void format_instruction(const struct DexInstruction& insn, const class DexFile* dex_file,
+                                   const RegisterNaming& registers, const MethodLabels* labels, OutputBuffer& out);
+
+    // Writes a switch or array-data payload block; switch targets are relative
+    // to the packed-/sparse-switch that `labels` records as referring to it
+    static void format_payload(const struct DexInstruction& payload, const uint16_t* insns, const MethodLabels& labels,
+                               OutputBuffer& out);
+
+    // Register operands are named once, as vN or pN, while formatting
+    static std::string format_register(uint32_t reg, const RegisterNaming& registers);
+    static void append_register(uint32_t reg, const RegisterNaming& registers, OutputBuffer& out);
+};
@@ -1,111 +1,97 @@
 #include "dex_file.hpp"
 #include "dex_structures.hpp"
 #include "dalvik_opcodes.hpp"
-#include <fstream>
+#include "../formatter/string_escape.hpp"
 #include <iostream>
 #include <cstring>
 #include <algorithm>
 #include <cstdio>
+#include <iterator>
 #include <map>
 #include <sstream>
 
-// Utility function to escape strings for smali output
-std::string escape_string_for_smali(const std::string& str) {
-    std::string result;
-    result.reserve(str.length() * 2);
-
-    for (size_t i = 0; i < str.length(); ++i) {
-        char c = str[i];
-
-        if (c == '\r') {
-            result += "\\r";
-            if (i + 1 < str.length() && str[i + 1] == '\n') {
-                result += "\\n";
-                ++i;
-            }
-            continue;
-        }
-        if (c == '\n') {
-            result += "\\n";
-            continue;
-        }
-
-        // Check if this is already an escaped sequence
-        if (c == '\\' && i + 1 < str.length()) {
-            char next = str[i + 1];
-            // If it's already a valid escape sequence, keep it as-is
-            if (next == 'n' || next == 'r' || next == 't' ||
-                next == '"' || next == '\'' || next == '\\') {
-                result += c;
-                result += next;
-                ++i;
-                continue;
-            } else if (next == 'u' && i + 5 < str.length()) {
-                bool isValidUnicode = true;
-                for (size_t j = 2; j <= 5; ++j) {
-                    char hex = str[i + j];
-                    if (!((hex >= '0' && hex <= '9') ||
-                          (hex >= 'a' && hex <= 'f') ||
-                          (hex >= 'A' && hex <= 'F'))) {
-                        isValidUnicode = false;
-                        break;
-                    }
-                }
-
-                if (isValidUnicode) {
-                    result += '\\';
-                    result += 'u';
-                    result.append(str, i + 2, 4);
-                    i += 5;
-                    continue;
-                }
-            }
-        }
-
-        // Only escape actual control characters, not already-escaped sequences
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\'': result += "\\'"; break;
-            case '\\': result += "\\\\"; break;  // Standard escaping: \\ -> \\\\\n            case '\t': result += "\\t"; break;
-            default: result += c; break;
-        }
-    }
-
-    return result;
-}
-
 std::unique_ptr<DexFile> DexFile::open(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file: " << filename << std::endl;
+    std::shared_ptr<const MappedFile> mapping = MappedFile::open(filename);
+    if (!mapping) {
         return nullptr;
     }
     
-    auto size = file.tellg();
-    file.seekg(0, std::ios::beg);
+    ByteView data = mapping->view();
+    return open(std::move(mapping), data);
+}
+
+std::unique_ptr<DexFile> DexFile::open(std::shared_ptr<const MappedFile> backing, ByteView data) {
+    // Header and id tables are read through aligned pointer casts
+    if (reinterpret_cast<uintptr_t>(data.data()) % alignof(uint32_t) != 0) {
+        return open(std::vector<uint8_t>(data.data(), data.data() + data.size()));
+    }
     
     auto dex_file = std::unique_ptr<DexFile>(new DexFile());
-    dex_file->file_data_.resize(size);
+    dex_file->mapping_ = std::move(backing);
+    dex_file->file_data_ = data;
     
-    if (!file.read(reinterpret_cast<char*>(dex_file->file_data_.data()), size)) {
-        std::cerr << "Error: Cannot read file: " << filename << std::endl;
+    if (!dex_file->load()) {
         return nullptr;
     }
+    return dex_file;
+}
+
+std::unique_ptr<DexFile> DexFile::open(std::vector<uint8_t> data) {
+    auto dex_file = std::unique_ptr<DexFile>(new DexFile());
+    dex_file->owned_data_ = std::move(data);
+    dex_file->file_data_ = ByteView(dex_file->owned_data_.data(), dex_file->owned_data_.size());
     
-    if (!dex_file->parse_header()) {
+    if (!dex_file->load()) {
         return nullptr;
     }
+    return dex_file;
+}
+
+bool DexFile::load() {
+    if (!parse_header()) {
+        return false;
+    }
     
-    if (!dex_file->parse_string_ids() ||
-        !dex_file->parse_type_ids() ||
-        !dex_file->parse_proto_ids() ||
-        !dex_file->parse_field_ids() ||
-        !dex_file->parse_method_ids() ||
-        !dex_file->parse_class_defs()) {
-        return nullptr;
+    apply_access_hints();
+    
+    if (!(parse_string_ids() &&
+          parse_type_ids() &&
+          parse_proto_ids() &&
+          parse_field_ids() &&
+          parse_method_ids() &&
+          parse_class_defs())) {
+        return false;
     }
     
-    return dex_file;
+    parse_map_list();
+    return true;
+}
+
+void DexFile::parse_map_list() {
+    // Call sites and method handles are only reachable through the map_list
+    if (header_->map_off == 0 || header_->map_off + sizeof(uint32_t) > file_data_.size()) {
+        return;
+    }
+    
+    const uint8_t* ptr = file_data_.data() + header_->map_off;
+    uint32_t map_size = *reinterpret_cast<const uint32_t*>(ptr);
+    if (header_->map_off + sizeof(uint32_t) + static_cast<size_t>(map_size) * sizeof(DexMapItem) > file_data_.size()) {
+        return;
+    }
+    
+    const DexMapItem* items = reinterpret_cast<const DexMapItem*>(ptr + sizeof(uint32_t));
+    for (uint32_t i = 0; i < map_size; ++i) {
+        const DexMapItem& item = items[i];
+        if (item.type == TYPE_METHOD_HANDLE_ITEM &&
+            item.offset + static_cast<size_t>(item.size) * sizeof(DexMethodHandleItem) <= file_data_.size()) {
+            method_handles_ = reinterpret_cast<const DexMethodHandleItem*>(file_data_.data() + item.offset);
+            method_handles_size_ = item.size;
+        } else if (item.type == TYPE_CALL_SITE_ID_ITEM &&
+                   item.offset + static_cast<size_t>(item.size) * sizeof(uint32_t) <= file_data_.size()) {
+            call_site_ids_ = reinterpret_cast<const uint32_t*>(file_data_.data() + item.offset);
+            call_site_ids_size_ = item.size;
+        }
+    }
 }
 
 DexFile::~DexFile() = default;
@@ -143,6 +129,55 @@ bool DexFile::parse_header() {
     return true;
 }
 
+void DexFile::apply_access_hints() {
+    if (!mapping_ || !mapping_->is_mapped()) {
+        return;
+    }
+    
+    // Offsets below are relative to the DEX image, which may start inside the mapping
+    size_t base = file_data_.data() - mapping_->data();
+    auto advise = [&](size_t offset, size_t length, MappedFile::Access access) {
+        mapping_->advise(base + offset, length, access);
+    };
+    
+    // Id tables and class_defs are walked front to back while loading
+    advise(header_->string_ids_off, header_->string_ids_size * sizeof(DexStringId), MappedFile::Access::SEQUENTIAL);
+    advise(header_->class_defs_off, header_->class_defs_size * sizeof(DexClassDef), MappedFile::Access::SEQUENTIAL);
+    
+    // Use the map_list to locate the code_item and string_data sections inside the data section
+    if (header_->map_off == 0 || header_->map_off + sizeof(uint32_t) > file_data_.size()) {
+        return;
+    }
+    
+    const uint8_t* ptr = file_data_.data() + header_->map_off;
+    uint32_t map_size = *reinterpret_cast<const uint32_t*>(ptr);
+    if (header_->map_off + sizeof(uint32_t) + static_cast<size_t>(map_size) * sizeof(DexMapItem) > file_data_.size()) {
+        return;
+    }
+    
+    std::vector<DexMapItem> items(map_size);
+    std::memcpy(items.data(), ptr + sizeof(uint32_t), map_size * sizeof(DexMapItem));
+    std::sort(items.begin(), items.end(), [](const DexMapItem& a, const DexMapItem& b) {
+        return a.offset < b.offset;
+    });
+    
+    // A section extends up to the start of the next one
+    for (size_t i = 0; i < items.size(); ++i) {
+        size_t start = items[i].offset;
+        size_t end = (i + 1 < items.size()) ? items[i + 1].offset : file_data_.size();
+        if (end <= start) {
+            continue;
+        }
+        
+        if (items[i].type == TYPE_CODE_ITEM) {
+            // Code items are visited in class_data order, not file order
+            advise(start, end - start, MappedFile::Access::RANDOM);
+        } else if (items[i].type == TYPE_STRING_DATA_ITEM) {
+            advise(start, end - start, MappedFile::Access::SEQUENTIAL);
+        }
+    }
+}
+
 // ULEB128 decoder
 uint32_t decode_uleb128(const uint8_t*& ptr) {
     uint32_t result = 0;
@@ -158,89 +193,29 @@ uint32_t decode_uleb128(const uint8_t*& ptr) {
     return result;
 }
 
-bool DexFile::parse_string_ids() {
-    if (header_->string_ids_size == 0) {
-        return true;
-    }
+// SLEB128 decoder
+int32_t decode_sleb128(const uint8_t*& ptr) {
+    int32_t result = 0;
+    int shift = 0;
+    uint8_t byte;
     
-    const uint8_t* data = file_data_.data() + header_->string_ids_off;
-    strings_.reserve(header_->string_ids_size);
+    do {
+        byte = *ptr++;
+        result |= static_cast<int32_t>(static_cast<uint32_t>(byte & 0x7F) << shift);
+        shift += 7;
+    } while ((byte & 0x80) && shift < 35);
     
-    for (uint32_t i = 0; i < header_->string_ids_size; ++i) {
-        // Bounds check for string ID array access
-        if (header_->string_ids_off + (i + 1) * sizeof(DexStringId) > file_data_.size()) {
-            std::cerr << "Error: String ID array access out of bounds" << std::endl;
-            return false;
-        }
-        
-        const DexStringId* string_id = reinterpret_cast<const DexStringId*>(data + i * sizeof(DexStringId));
-        
-        if (string_id->string_data_off >= file_data_.size()) {
-            std::cerr << "Error: Invalid string data offset" << std::endl;
-            return false;
-        }
-        
-        const uint8_t* string_data = file_data_.data() + string_id->string_data_off;
-        const uint8_t* ptr = string_data;
-        uint32_t utf16_size = decode_uleb128(ptr);
-
-        // Read the UTF-8 string safely - ptr now points past the ULEB128
-        const char* str_start = reinterpret_cast<const char*>(ptr);
-        const char* file_end = reinterpret_cast<const char*>(file_data_.data() + file_data_.size());
-        size_t max_len = file_end - str_start;
-        size_t str_len = strnlen(str_start, max_len);
-
-        if (str_start + str_len >= file_end) {
-            std::cerr << "Error: String extends beyond file boundary" << std::endl;
-            return false;
-        }
-
-        // Convert non-ASCII characters to Unicode escape sequences (matching Java baksmali behavior)
-        std::string str;
-        str.reserve(str_len * 2); // Reserve space for potential escaping
-
-        // Debug output removed for production
-
-        for (size_t j = 0; j < str_len; ++j) {
-            unsigned char c = static_cast<unsigned char>(str_start[j]);
-
-            if (c < 0x80) {
-                // ASCII character - add as-is
-                str.push_back(c);
-            } else {
-                // Non-ASCII UTF-8 sequence - convert to Unicode escape
-                // Handle UTF-8 decoding to get the Unicode code point
-                uint32_t codepoint = 0;
-                size_t remaining = str_len - j;
-
-                if ((c & 0xE0) == 0xC0 && remaining >= 2) {
-                    // 2-byte UTF-8 sequence
-                    codepoint = ((c & 0x1F) << 6) | (str_start[j + 1] & 0x3F);
-                    j += 1;
-                } else if ((c & 0xF0) == 0xE0 && remaining >= 3) {
-                    // 3-byte UTF-8 sequence
-                    codepoint = ((c & 0x0F) << 12) | ((str_start[j + 1] & 0x3F) << 6) | (str_start[j + 2] & 0x3F);
-                    j += 2;
-                } else if ((c & 0xF8) == 0xF0 && remaining >= 4) {
-                    // 4-byte UTF-8 sequence
-                    codepoint = ((c & 0x07) << 18) | ((str_start[j + 1] & 0x3F) << 12) | ((str_start[j + 2] & 0x3F) << 6) | (str_start[j + 3] & 0x3F);
-                    j += 3;
-                } else {
-                    // Invalid UTF-8 or truncated - treat as single byte
-                    codepoint = c;
-                }
-
-                // Format as Unicode escape sequence
-                char escape[7];
-                snprintf(escape, sizeof(escape), "\\u%04x", codepoint & 0xFFFF);
-                str.append(escape);
-            }
-        }
-
-        strings_.push_back(std::move(str));
+    // Sign-extend from the last byte's sign bit
+    if (shift < 32 && (byte & 0x40)) {
+        result |= static_cast<int32_t>(~0u << shift);
     }
-    
-    return true;
+    return result;
+}
+
+bool DexFile::parse_string_ids() {
+    // Only indexed here; strings are decoded when first looked up
+    string_literals_.reset(header_->string_ids_size);
+    return strings_.load(file_data_, header_->string_ids_off, header_->string_ids_size);
 }
 
 bool DexFile::parse_type_ids() {
@@ -265,7 +240,7 @@ bool DexFile::parse_type_ids() {
             return false;
         }
         
-        type_names_.push_back(strings_[type_id->descriptor_idx]);
+        type_names_.push_back(strings_.get(type_id->descriptor_idx));
     }
     
     return true;
@@ -314,6 +289,8 @@ bool DexFile::parse_proto_ids() {
 }
 
 bool DexFile::parse_field_ids() {
+    field_references_.reset(header_->field_ids_size);
+    
     if (header_->field_ids_size == 0) {
         return true;
     }
@@ -329,13 +306,15 @@ bool DexFile::parse_field_ids() {
             return false;
         }
         
-        field_names_.push_back(strings_[field_id->name_idx]);
+        field_names_.push_back(strings_.get(field_id->name_idx));
     }
     
     return true;
 }
 
 bool DexFile::parse_method_ids() {
+    method_references_.reset(header_->method_ids_size);
+    
     if (header_->method_ids_size == 0) {
         return true;
     }
@@ -351,7 +330,7 @@ bool DexFile::parse_method_ids() {
             return false;
         }
         
-        method_names_.push_back(strings_[method_id->name_idx]);
+        method_names_.push_back(strings_.get(method_id->name_idx));
     }
     
     return true;
@@ -362,92 +341,271 @@ bool DexFile::parse_class_defs() {
         return true;
     }
     
-    const uint8_t* data = file_data_.data() + header_->class_defs_off;
-    classes_.reserve(header_->class_defs_size);
+    if (header_->class_defs_off + static_cast<size_t>(header_->class_defs_size) * sizeof(DexClassDef) > file_data_.size()) {
+        std::cerr << "Error: Class definitions out of bounds" << std::endl;
+        return false;
+    }
     
-    for (uint32_t i = 0; i < header_->class_defs_size; ++i) {
-        const DexClassDef* class_def = reinterpret_cast<const DexClassDef*>(data + i * sizeof(DexClassDef));
-        
-        DexClass dex_class;
-        dex_class.class_idx = class_def->class_idx;
-        dex_class.access_flags = class_def->access_flags;
-        
-        if (class_def->class_idx < type_names_.size()) {
-            dex_class.class_name = type_names_[class_def->class_idx];
-        }
-        
-        if (class_def->superclass_idx != 0xFFFFFFFF && class_def->superclass_idx < type_names_.size()) {
-            dex_class.superclass_name = type_names_[class_def->superclass_idx];
-        }
-        
-        if (class_def->source_file_idx != 0xFFFFFFFF && class_def->source_file_idx < strings_.size()) {
-            dex_class.source_file = strings_[class_def->source_file_idx];
-        }
-        
-        // Parse interfaces
-        if (class_def->interfaces_off != 0) {
-            parse_interfaces(class_def->interfaces_off, dex_class);
-        }
-        
-        // Parse class data (fields and methods)
-        if (class_def->class_data_off != 0) {
-            parse_class_data(class_def->class_data_off, dex_class);
-        }
-        
-        // Parse annotations
-        if (class_def->annotations_off != 0) {
-            parse_annotations_directory(class_def->annotations_off, dex_class);
-        }
+    class_defs_ = reinterpret_cast<const DexClassDef*>(file_data_.data() + header_->class_defs_off);
+    build_class_index();
+    return true;
+}
+
+void DexFile::build_class_index() {
+    classes_by_descriptor_.resize(class_count());
+    for (uint32_t i = 0; i < class_count(); ++i) {
+        classes_by_descriptor_[i] = i;
+    }
+    
+    std::sort(classes_by_descriptor_.begin(), classes_by_descriptor_.end(), [this](uint32_t a, uint32_t b) {
+        return class_descriptor(a) < class_descriptor(b);
+    });
+}
+
+std::optional<uint32_t> DexFile::find_class(std::string_view descriptor) const {
+    auto it = std::lower_bound(classes_by_descriptor_.begin(), classes_by_descriptor_.end(), descriptor,
+                               [this](uint32_t index, std::string_view value) {
+                                   return class_descriptor(index) < value;
+                               });
+    if (it != classes_by_descriptor_.end() && class_descriptor(*it) == descriptor) {
+        return *it;
+    }
+    return std::nullopt;
+}
 
-        // Parse static values to get initial values for static final fields
-        if (class_def->static_values_off != 0) {
-            parse_static_values(class_def->static_values_off, dex_class);
+std::vector<uint32_t> DexFile::find_classes_with_prefix(std::string_view prefix) const {
+    // Descriptors sharing a prefix form one contiguous run of the sorted index
+    auto first = std::lower_bound(classes_by_descriptor_.begin(), classes_by_descriptor_.end(), prefix,
+                                  [this](uint32_t index, std::string_view value) {
+                                      return class_descriptor(index) < value;
+                                  });
+    
+    std::vector<uint32_t> result;
+    for (auto it = first; it != classes_by_descriptor_.end(); ++it) {
+        std::string_view descriptor = class_descriptor(*it);
+        if (descriptor.compare(0, prefix.size(), prefix) != 0) {
+            break;
         }
+        result.push_back(*it);
+    }
+    return result;
+}
+
+const DexClassDef& DexFile::class_def(uint32_t index) const {
+    return class_defs_[index];
+}
 
-        classes_.push_back(std::move(dex_class));
+std::string_view DexFile::class_descriptor(uint32_t index) const {
+    uint32_t class_idx = class_defs_[index].class_idx;
+    return class_idx < type_names_.size() ? type_names_[class_idx] : std::string_view();
+}
+
+DexClassSummary DexFile::summarize_class(uint32_t index) const {
+    DexClassSummary summary;
+    const DexClassDef& class_def = class_defs_[index];
+    if (class_def.class_data_off == 0 || class_def.class_data_off >= file_data_.size()) {
+        return summary;
     }
     
-    // Add annotations after all classes are parsed
-    for (auto& dex_class : classes_) {
-        add_member_classes_annotation(dex_class);
+    // Walk class_data without building anything; only code_item headers are touched
+    const uint8_t* ptr = file_data_.data() + class_def.class_data_off;
+    uint32_t static_fields_size = decode_uleb128(ptr);
+    uint32_t instance_fields_size = decode_uleb128(ptr);
+    uint32_t direct_methods_size = decode_uleb128(ptr);
+    uint32_t virtual_methods_size = decode_uleb128(ptr);
+    
+    summary.field_count = static_fields_size + instance_fields_size;
+    summary.method_count = direct_methods_size + virtual_methods_size;
+    
+    for (uint32_t i = 0; i < summary.field_count; ++i) {
+        decode_uleb128(ptr); // field_idx_diff
+        decode_uleb128(ptr); // access_flags
     }
     
-    return true;
+    for (uint32_t i = 0; i < summary.method_count; ++i) {
+        decode_uleb128(ptr); // method_idx_diff
+        decode_uleb128(ptr); // access_flags
+        uint32_t code_off = decode_uleb128(ptr);
+        if (code_off != 0 && code_off + sizeof(DexCodeItem) <= file_data_.size()) {
+            const DexCodeItem* code = reinterpret_cast<const DexCodeItem*>(file_data_.data() + code_off);
+            summary.insns_size += code->insns_size;
+        }
+    }
+    
+    return summary;
 }
 
-std::string DexFile::get_string(uint32_t string_idx) const {
-    if (string_idx >= strings_.size()) {
-        return "";
+ArenaPtr<DexClass> DexFile::load_class(uint32_t index, std::pmr::memory_resource* resource) const {
+    if (index >= class_count()) {
+        return nullptr;
+    }
+    
+    const DexClassDef* class_def = &class_defs_[index];
+    
+    auto dex_class = arena_new<DexClass>(resource, resource);
+    dex_class->class_idx = class_def->class_idx;
+    dex_class->access_flags = class_def->access_flags;
+    dex_class->class_name = class_descriptor(index);
+    
+    if (class_def->superclass_idx != 0xFFFFFFFF && class_def->superclass_idx < type_names_.size()) {
+        dex_class->superclass_name = type_names_[class_def->superclass_idx];
+    }
+    
+    if (class_def->source_file_idx != 0xFFFFFFFF && class_def->source_file_idx < strings_.size()) {
+        dex_class->source_file = strings_.get(class_def->source_file_idx);
+    }
+    
+    // Parse interfaces
+    if (class_def->interfaces_off != 0) {
+        parse_interfaces(class_def->interfaces_off, *dex_class);
+    }
+    
+    // Parse class data (fields and methods)
+    if (class_def->class_data_off != 0) {
+        parse_class_data(class_def->class_data_off, *dex_class);
+    }
+    
+    // Parse annotations
+    if (features_.annotations && class_def->annotations_off != 0) {
+        parse_annotations_directory(class_def->annotations_off, *dex_class);
+    }
+
+    // Parse static values to get initial values for static final fields
+    if (features_.static_values && class_def->static_values_off != 0) {
+        parse_static_values(class_def->static_values_off, *dex_class);
     }
-    return strings_[string_idx];
+    
+    if (features_.annotations) {
+        add_member_classes_annotation(*dex_class);
+    }
+    
+    return dex_class;
+}
+
+std::string_view DexFile::get_string(uint32_t string_idx) const {
+    return strings_.get(string_idx);
 }
 
-std::string DexFile::get_type_name(uint32_t type_idx) const {
+std::string_view DexFile::get_type_name(uint32_t type_idx) const {
     if (type_idx >= type_names_.size()) {
-        return "";
+        return {};
     }
     return type_names_[type_idx];
 }
 
-std::string DexFile::get_method_name(uint32_t method_idx) const {
+std::string_view DexFile::get_method_name(uint32_t method_idx) const {
     if (method_idx >= method_names_.size()) {
-        return "";
+        return {};
     }
     return method_names_[method_idx];
 }
 
-std::string DexFile::get_field_name(uint32_t field_idx) const {
+std::string_view DexFile::get_field_name(uint32_t field_idx) const {
     if (field_idx >= field_names_.size()) {
-        return "";
+        return {};
     }
     return field_names_[field_idx];
 }
 
-std::string DexFile::get_method_reference(uint32_t method_idx) const {
-    if (method_idx >= header_->method_ids_size) {
+const std::string& DexFile::get_proto(uint32_t proto_idx) const {
+    static const std::string empty;
+    if (proto_idx >= proto_signatures_.size()) {
+        return empty;
+    }
+    return proto_signatures_[proto_idx];
+}
+
+std::string DexFile::get_method_handle(uint32_t method_handle_idx) const {
+    if (method_handle_idx >= method_handles_size_) {
+        return "";
+    }
+    
+    static const char* const kinds[] = {
+        "static-put", "static-get", "instance-put", "instance-get",
+        "invoke-static", "invoke-instance", "invoke-constructor", "invoke-direct", "invoke-interface"};
+    const DexMethodHandleItem& handle = method_handles_[method_handle_idx];
+    if (handle.method_handle_type >= sizeof(kinds) / sizeof(kinds[0])) {
+        return "";
+    }
+    
+    // The first four kinds refer to a field, the rest to a method
+    std::string result = kinds[handle.method_handle_type];
+    result += "@";
+    if (handle.method_handle_type <= 0x03) {
+        result += get_field_reference(handle.field_or_method_id);
+    } else {
+        result += get_method_reference(handle.field_or_method_id);
+    }
+    return result;
+}
+
+std::string DexFile::get_call_site(uint32_t call_site_idx) const {
+    if (call_site_idx >= call_site_ids_size_ || call_site_ids_[call_site_idx] >= file_data_.size()) {
+        return "";
+    }
+    
+    // encoded_array_item: bootstrap method handle, method name, method type, extra arguments
+    const uint8_t* ptr = file_data_.data() + call_site_ids_[call_site_idx];
+    uint32_t size = decode_uleb128(ptr);
+    if (size < 3) {
         return "";
     }
     
+    std::string bootstrap = parse_encoded_value(ptr);
+    std::string method_name = parse_encoded_value(ptr);
+    std::string method_type = parse_encoded_value(ptr);
+    
+    std::string result = "call_site_" + std::to_string(call_site_idx) + "(" + method_name + ", " + method_type;
+    for (uint32_t i = 3; i < size; ++i) {
+        result += ", ";
+        result += parse_encoded_value(ptr);
+    }
+    result += ")@";
+    
+    // Only the bootstrap method is printed, not its handle kind
+    size_t at = bootstrap.find('@');
+    result += at == std::string::npos ? bootstrap : bootstrap.substr(at + 1);
+    return result;
+}
+
+std::string_view DexFile::get_method_reference(uint32_t method_idx) const {
+    if (method_idx >= method_references_.size()) {
+        return {};
+    }
+    return method_references_.get(method_idx, [this](uint32_t idx) { return build_method_reference(idx); });
+}
+
+std::string_view DexFile::get_field_reference(uint32_t field_idx) const {
+    if (field_idx >= field_references_.size()) {
+        return {};
+    }
+    return field_references_.get(field_idx, [this](uint32_t idx) { return build_field_reference(idx); });
+}
+
+std::string_view DexFile::get_string_literal(uint32_t string_idx) const {
+    if (string_idx >= string_literals_.size()) {
+        return "\"\"";
+    }
+    return string_literals_.get(string_idx, [this](uint32_t idx) { return build_string_literal(idx); });
+}
+
+DexFile::ReferenceCacheStats DexFile::reference_cache_stats() const {
+    ReferenceCacheStats stats;
+    stats.methods = method_references_.stats();
+    stats.fields = field_references_.stats();
+    stats.literals = string_literals_.stats();
+    return stats;
+}
+
+std::string DexFile::build_string_literal(uint32_t string_idx) const {
+    OutputBuffer literal(strings_.data(string_idx).size() + 2);
+    literal << '"';
+    append_escaped_literal(literal, strings_.data(string_idx));
+    literal << '"';
+    return std::string(literal.view());
+}
+
+std::string DexFile::build_method_reference(uint32_t method_idx) const {    
     const uint8_t* method_data = file_data_.data() + header_->method_ids_off + method_idx * sizeof(DexMethodId);
     const DexMethodId* method_id = reinterpret_cast<const DexMethodId*>(method_data);
     
@@ -462,7 +620,7 @@ std::string DexFile::get_method_reference(uint32_t method_idx) const {
     
     // Add method name
     if (method_id->name_idx < strings_.size()) {
-        result += strings_[method_id->name_idx];
+        result += strings_.get(method_id->name_idx);
     }
     
     // Add signature
@@ -473,11 +631,7 @@ std::string DexFile::get_method_reference(uint32_t method_idx) const {
     return result;
 }
 
-std::string DexFile::get_field_reference(uint32_t field_idx) const {
-    if (field_idx >= header_->field_ids_size) {
-        return "";
-    }
-    
+std::string DexFile::build_field_reference(uint32_t field_idx) const {    
     const uint8_t* field_data = file_data_.data() + header_->field_ids_off + field_idx * sizeof(DexFieldId);
     const DexFieldId* field_id = reinterpret_cast<const DexFieldId*>(field_data);
     
@@ -492,7 +646,7 @@ std::string DexFile::get_field_reference(uint32_t field_idx) const {
     
     // Add field name
     if (field_id->name_idx < strings_.size()) {
-        result += strings_[field_id->name_idx];
+        result += strings_.get(field_id->name_idx);
     }
     
     result += ":";
@@ -505,7 +659,7 @@ std::string DexFile::get_field_reference(uint32_t field_idx) const {
     return result;
 }
 
-bool DexFile::parse_interfaces(uint32_t interfaces_off, DexClass& dex_class) {
+bool DexFile::parse_interfaces(uint32_t interfaces_off, DexClass& dex_class) const {
     if (interfaces_off >= file_data_.size()) {
         return false;
     }
@@ -519,14 +673,14 @@ bool DexFile::parse_interfaces(uint32_t interfaces_off, DexClass& dex_class) {
         ptr += sizeof(uint16_t);
         
         if (type_idx < type_names_.size()) {
-            dex_class.interfaces.push_back(type_names_[type_idx]);
+            dex_class.interfaces.emplace_back(type_names_[type_idx]);
         }
     }
     
     return true;
 }
 
-bool DexFile::parse_class_data(uint32_t class_data_off, DexClass& dex_class) {
+bool DexFile::parse_class_data(uint32_t class_data_off, DexClass& dex_class) const {
     if (class_data_off >= file_data_.size()) {
         return false;
     }
@@ -562,12 +716,13 @@ bool DexFile::parse_class_data(uint32_t class_data_off, DexClass& dex_class) {
     return true;
 }
 
-bool DexFile::parse_encoded_fields(const uint8_t*& ptr, uint32_t count, std::vector<DexField>& fields, bool is_static) {
+bool DexFile::parse_encoded_fields(const uint8_t*& ptr, uint32_t count, std::pmr::vector<DexField>& fields, bool is_static) const {
+    std::pmr::memory_resource* resource = fields.get_allocator().resource();
     fields.reserve(count);
     uint32_t field_idx = 0;
     
     for (uint32_t i = 0; i < count; ++i) {
-        DexField field;
+        DexField& field = fields.emplace_back(resource);
         
         uint32_t field_idx_diff = decode_uleb128(ptr);
         field_idx += field_idx_diff;
@@ -581,7 +736,7 @@ bool DexFile::parse_encoded_fields(const uint8_t*& ptr, uint32_t count, std::vec
             const DexFieldId* field_id = reinterpret_cast<const DexFieldId*>(field_data);
             
             if (field_id->name_idx < strings_.size()) {
-                field.name = strings_[field_id->name_idx];
+                field.name = strings_.get(field_id->name_idx);
             }
             
             if (field_id->type_idx < type_names_.size()) {
@@ -592,19 +747,18 @@ bool DexFile::parse_encoded_fields(const uint8_t*& ptr, uint32_t count, std::vec
                 field.class_name = type_names_[field_id->class_idx];
             }
         }
-        
-        fields.push_back(std::move(field));
     }
     
     return true;
 }
 
-bool DexFile::parse_encoded_methods(const uint8_t*& ptr, uint32_t count, std::vector<DexMethod>& methods, bool is_direct) {
+bool DexFile::parse_encoded_methods(const uint8_t*& ptr, uint32_t count, std::pmr::vector<DexMethod>& methods, bool is_direct) const {
+    std::pmr::memory_resource* resource = methods.get_allocator().resource();
     methods.reserve(count);
     uint32_t method_idx = 0;
     
     for (uint32_t i = 0; i < count; ++i) {
-        DexMethod method;
+        DexMethod& method = methods.emplace_back(resource);
         
         uint32_t method_idx_diff = decode_uleb128(ptr);
         method_idx += method_idx_diff;
@@ -619,7 +773,7 @@ bool DexFile::parse_encoded_methods(const uint8_t*& ptr, uint32_t count, std::ve
             const DexMethodId* method_id = reinterpret_cast<const DexMethodId*>(method_data);
             
             if (method_id->name_idx < strings_.size()) {
-                method.name = strings_[method_id->name_idx];
+                method.name = strings_.get(method_id->name_idx);
             }
             
             if (method_id->class_idx < type_names_.size()) {
@@ -636,16 +790,14 @@ bool DexFile::parse_encoded_methods(const uint8_t*& ptr, uint32_t count, std::ve
         
         // Parse code if present
         if (code_off != 0 && code_off < file_data_.size()) {
-            method.code = parse_code_item(code_off, &method);
+            method.code = parse_code_item(code_off, resource);
         }
-        
-        methods.push_back(std::move(method));
     }
     
     return true;
 }
 
-std::unique_ptr<DexCode> DexFile::parse_code_item(uint32_t code_off, DexMethod* method_context) {
+ArenaPtr<DexCode> DexFile::parse_code_item(uint32_t code_off, std::pmr::memory_resource* resource) const {
     if (code_off >= file_data_.size()) {
         return nullptr;
     }
@@ -653,7 +805,7 @@ std::unique_ptr<DexCode> DexFile::parse_code_item(uint32_t code_off, DexMethod*
     const uint8_t* ptr = file_data_.data() + code_off;
     const DexCodeItem* code_header = reinterpret_cast<const DexCodeItem*>(ptr);
     
-    auto code = std::make_unique<DexCode>();
+    auto code = arena_new<DexCode>(resource, resource);
     code->registers_size = code_header->registers_size;
     code->ins_size = code_header->ins_size;
     code->outs_size = code_header->outs_size;
@@ -666,101 +818,150 @@ std::unique_ptr<DexCode> DexFile::parse_code_item(uint32_t code_off, DexMethod*
         // Skip past the fixed-size code_item header (16 bytes)
         // registers_size(2) + ins_size(2) + outs_size(2) + tries_size(2) + debug_info_off(4) + insns_size(4) = 16
         const uint16_t* insns = reinterpret_cast<const uint16_t*>(ptr + 16);
-        parse_instructions(insns, code_header->insns_size, code->instructions);
+        code->insns = insns;
+        parse_instructions(insns, code_header->insns_size, *code);
     }
 
-    // Parse debug info if available
-    if (code_header->debug_info_off != 0) {
-        parse_debug_info(code_header->debug_info_off, *code, method_context);
+    if (code_header->tries_size > 0) {
+        parse_tries(ptr, *code);
     }
 
     return code;
 }
 
-void DexFile::parse_instructions(const uint16_t* insns, uint32_t insns_size, std::vector<DexInstruction>& instructions) {
-    uint32_t offset = 0;
+void DexFile::parse_tries(const uint8_t* code_item, DexCode& code) const {
+    // try_items follow the instructions, padded to a 4-byte boundary
+    size_t tries_off = (code_item - file_data_.data()) + 16 + code.insns_size * 2 + ((code.insns_size & 1) ? 2 : 0);
+    if (tries_off + code.tries_size * sizeof(DexTryItem) > file_data_.size()) {
+        return;
+    }
+    const DexTryItem* try_items = reinterpret_cast<const DexTryItem*>(file_data_.data() + tries_off);
+    const uint8_t* handler_lists = file_data_.data() + tries_off + code.tries_size * sizeof(DexTryItem);
     
-    while (offset < insns_size) {
-        DexInstruction instruction;
-        instruction.address = offset; // Debug info uses code units, keep same scale
-        instruction.opcode = insns[offset] & 0xFF;
-        
-        int width = DalvikInstructionParser::get_instruction_width(instruction.opcode);
+    // Try blocks often share a handler list; decode each distinct list once
+    std::vector<uint16_t> list_offsets;
+    list_offsets.reserve(code.tries_size);
+    for (uint16_t i = 0; i < code.tries_size; ++i) {
+        list_offsets.push_back(try_items[i].handler_off);
+    }
+    std::sort(list_offsets.begin(), list_offsets.end());
+    list_offsets.erase(std::unique(list_offsets.begin(), list_offsets.end()), list_offsets.end());
+    
+    std::vector<uint32_t> list_ends(list_offsets.size());
+    for (size_t i = 0; i < list_offsets.size(); ++i) {
+        const uint8_t* ptr = handler_lists + list_offsets[i];
+        if (ptr >= file_data_.data() + file_data_.size()) {
+            list_ends[i] = static_cast<uint32_t>(code.catch_handlers.size());
+            continue;
+        }
         
-        // Store raw instruction data
-        instruction.operands.clear();
-        for (int i = 0; i < width && (offset + i) < insns_size; ++i) {
-            instruction.operands.push_back(insns[offset + i]);
+        // A size <= 0 means -size typed handlers followed by a catch-all
+        int32_t size = decode_sleb128(ptr);
+        uint32_t typed = size < 0 ? 0 - static_cast<uint32_t>(size) : static_cast<uint32_t>(size);
+        for (uint32_t j = 0; j < typed; ++j) {
+            uint32_t type_idx = decode_uleb128(ptr);
+            uint32_t address = decode_uleb128(ptr);
+            code.catch_handlers.push_back({type_idx, address});
         }
+        if (size <= 0) {
+            code.catch_handlers.push_back({DexCatchHandler::CATCH_ALL, decode_uleb128(ptr)});
+        }
+        list_ends[i] = static_cast<uint32_t>(code.catch_handlers.size());
+    }
+    
+    code.tries.reserve(code.tries_size);
+    for (uint16_t i = 0; i < code.tries_size; ++i) {
+        const DexTryItem& item = try_items[i];
+        size_t list = std::lower_bound(list_offsets.begin(), list_offsets.end(), item.handler_off) - list_offsets.begin();
         
-        // Format the instruction mnemonic
-        instruction.mnemonic = DalvikInstructionParser::format_instruction(&insns[offset], instruction.address, this);
+        DexTryBlock block;
+        block.start_address = item.start_addr;
+        block.end_address = item.start_addr + item.insn_count;
+        block.handlers_begin = list == 0 ? 0 : list_ends[list - 1];
+        block.handlers_end = list_ends[list];
         
-        instructions.push_back(instruction);
-        offset += width;
+        // The end label and .catch lines go after the last covered instruction
+        auto after = std::lower_bound(code.instructions.begin(), code.instructions.end(), block.end_address,
+                                      [](const DexInstruction& insn, uint32_t address) { return insn.address < address; });
+        block.last_address = after == code.instructions.begin() ? block.start_address : std::prev(after)->address;
+        code.tries.push_back(block);
     }
+    
+    std::sort(code.tries.begin(), code.tries.end(), [](const DexTryBlock& a, const DexTryBlock& b) {
+        return a.start_address < b.start_address;
+    });
 }
 
-void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const DexMethod* method_context) {
+void DexFile::parse_instructions(const uint16_t* insns, uint32_t insns_size, DexCode& code) const {
+    // Count first so the decoded array is allocated exactly once
+    size_t count = 0;
+    for (uint32_t offset = 0; offset < insns_size; offset += DalvikInstructionParser::instruction_width(insns, insns_size, offset)) {
+        ++count;
+    }
+    code.instructions.resize(count);
+
+    // Decode only; text is rendered once, when the class is written
+    uint32_t offset = 0;
+    for (DexInstruction& instruction : code.instructions) {
+        DalvikInstructionParser::decode_instruction(insns, insns_size, offset, instruction);
+        offset += instruction.width;
+    }
+}
+
+void DexFile::decode_debug_info(const DexMethod& method, std::pmr::vector<DebugItem>& items) const {
+    items.clear();
+    if (features_.debug_info && method.code && method.code->debug_info_off != 0) {
+        parse_debug_info(method.code->debug_info_off, *method.code, &method, items);
+    }
+}
+
+void DexFile::parse_debug_info(uint32_t debug_info_off, const DexCode& code, const DexMethod* method_context,
+                               std::pmr::vector<DebugItem>& items) const {
     if (debug_info_off >= file_data_.size()) {
         return;
     }
 
     const uint8_t* ptr = file_data_.data() + debug_info_off;
     const uint8_t* end = file_data_.data() + file_data_.size();
+    constexpr uint32_t NO_INDEX = DebugItem::NO_INDEX;
+
+    // Ids are stored +1 in debug info, with 0 meaning none
+    auto string_id = [this](uint32_t idx_p1) {
+        return (idx_p1 != 0 && idx_p1 <= strings_.size()) ? idx_p1 - 1 : NO_INDEX;
+    };
+    auto type_id = [this](uint32_t idx_p1) {
+        return (idx_p1 != 0 && idx_p1 <= type_names_.size()) ? idx_p1 - 1 : NO_INDEX;
+    };
 
     uint32_t line_start = decode_uleb128(ptr);
     uint32_t parameters_size = decode_uleb128(ptr);
 
-    std::vector<std::string> parameter_names;
+    std::vector<uint32_t> parameter_names;
     parameter_names.reserve(parameters_size);
     for (uint32_t i = 0; i < parameters_size; ++i) {
-        uint32_t name_idx = decode_uleb128(ptr);
-        if (name_idx != 0 && name_idx <= strings_.size()) {
-            parameter_names.push_back(strings_[name_idx - 1]);
-        } else {
-            parameter_names.emplace_back();
-        }
-    }
-
-    auto parse_parameter_types = [](const std::string& proto) {
-        std::vector<std::string> types;
-        if (proto.empty()) {
-            return types;
-        }
-        auto paren_pos = proto.find('(');
-        if (paren_pos == std::string::npos) {
-            return types;
-        }
-        size_t index = paren_pos + 1;
-        while (index < proto.size() && proto[index] != ')') {
-            size_t type_start = index;
-            while (index < proto.size() && proto[index] == '[') {
-                ++index;
-            }
-            if (index >= proto.size()) {
-                break;
-            }
-            if (proto[index] == 'L') {
-                size_t semi = proto.find(';', index);
-                if (semi == std::string::npos) {
-                    break;
-                }
-                index = semi + 1;
-            } else {
-                ++index;
+        parameter_names.push_back(string_id(decode_uleb128(ptr)));
+    }
+
+    // Parameter types come from the method's prototype, as type ids
+    std::vector<uint32_t> parameter_types;
+    uint32_t class_type = NO_INDEX;
+    if (method_context && method_context->method_idx < header_->method_ids_size) {
+        const DexMethodId* method_id = reinterpret_cast<const DexMethodId*>(
+            file_data_.data() + header_->method_ids_off + method_context->method_idx * sizeof(DexMethodId));
+        class_type = method_id->class_idx;
+        if (method_id->proto_idx < header_->proto_ids_size) {
+            const DexProtoId* proto_id = reinterpret_cast<const DexProtoId*>(
+                file_data_.data() + header_->proto_ids_off + method_id->proto_idx * sizeof(DexProtoId));
+            if (proto_id->parameters_off != 0) {
+                const uint8_t* param_data = file_data_.data() + proto_id->parameters_off;
+                uint32_t param_count = *reinterpret_cast<const uint32_t*>(param_data);
+                const uint16_t* type_list = reinterpret_cast<const uint16_t*>(param_data + sizeof(uint32_t));
+                parameter_types.assign(type_list, type_list + param_count);
             }
-            types.push_back(proto.substr(type_start, index - type_start));
         }
-        return types;
-    };
-
-    std::vector<std::string> parameter_types;
-    if (method_context) {
-        parameter_types = parse_parameter_types(method_context->signature);
     }
 
-    enum class LocalKind {
+    enum class LocalKind : uint8_t {
         NONE,
         START,
         END,
@@ -768,24 +969,23 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
     };
 
     struct LocalState {
-        std::string name;
-        std::string type_descriptor;
-        std::string signature;
+        uint32_t name_idx = NO_INDEX;
+        uint32_t type_idx = NO_INDEX;
+        uint32_t signature_idx = NO_INDEX;
         LocalKind kind = LocalKind::NONE;
     };
 
     size_t register_count = code.registers_size;
     std::vector<LocalState> locals(register_count);
-    LocalState empty_state;
-    std::fill(locals.begin(), locals.end(), empty_state);
+    const LocalState empty_state;
 
     int parameter_index = 0;
     size_t param_name_index = 0;
 
     if (method_context && !(method_context->access_flags & ACC_STATIC)) {
         LocalState this_state;
-        this_state.name = "this";
-        this_state.type_descriptor = method_context->class_name;
+        this_state.name_idx = DebugItem::THIS_NAME;
+        this_state.type_idx = class_type;
         this_state.kind = LocalKind::START;
         if (parameter_index < static_cast<int>(register_count)) {
             locals[parameter_index] = this_state;
@@ -793,13 +993,13 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
         ++parameter_index;
     }
 
-    for (const auto& type : parameter_types) {
+    for (uint32_t type : parameter_types) {
         LocalState param_state;
         if (param_name_index < parameter_names.size()) {
-            param_state.name = parameter_names[param_name_index];
+            param_state.name_idx = parameter_names[param_name_index];
         }
         ++param_name_index;
-        param_state.type_descriptor = type;
+        param_state.type_idx = type;
         param_state.kind = LocalKind::START;
         if (parameter_index < static_cast<int>(register_count)) {
             locals[parameter_index] = param_state;
@@ -811,7 +1011,8 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
         int local_index = static_cast<int>(register_count) - 1;
         while (--parameter_index > -1) {
             LocalState current = locals[parameter_index];
-            bool is_wide = current.type_descriptor == "J" || current.type_descriptor == "D";
+            std::string_view type_name = get_type_name(current.type_idx);
+            bool is_wide = type_name == "J" || type_name == "D";
             if (is_wide) {
                 --local_index;
                 if (local_index == parameter_index) {
@@ -829,6 +1030,20 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
     uint32_t address = 0;
     int32_t line = static_cast<int32_t>(line_start);
 
+    auto add_item = [&items, &address](DebugItem::Type type) -> DebugItem& {
+        DebugItem& item = items.emplace_back();
+        item.type = type;
+        item.address = address;
+        return item;
+    };
+    auto add_local = [&add_item](DebugItem::Type type, uint32_t register_num, const LocalState& state) {
+        DebugItem& item = add_item(type);
+        item.register_num = register_num;
+        item.name_idx = state.name_idx;
+        item.type_idx = state.type_idx;
+        item.signature_idx = state.signature_idx;
+    };
+
     while (ptr < end) {
         uint8_t opcode = *ptr++;
 
@@ -843,44 +1058,25 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
             }
 
             case DBG_ADVANCE_LINE: {
-                int32_t line_diff = static_cast<int32_t>(decode_uleb128(ptr));
-                line += line_diff;
-                break;
-            }
-
-            case DBG_START_LOCAL: {
-                uint32_t register_num = decode_uleb128(ptr);
-                uint32_t name_idx = decode_uleb128(ptr);
-                uint32_t type_idx = decode_uleb128(ptr);
-
-                std::string name = (name_idx != 0 && name_idx <= strings_.size()) ? strings_[name_idx - 1] : "";
-                std::string type = (type_idx != 0 && type_idx <= type_names_.size()) ? type_names_[type_idx - 1] : "";
-
-                if (register_num < locals.size()) {
-                    locals[register_num] = {name, type, "", LocalKind::START};
-                }
-
-                auto item = std::make_unique<StartLocalItem>(address, register_num, name, type);
-                code.debug_items.push_back(std::move(item));
+                line += decode_sleb128(ptr);
                 break;
             }
 
+            case DBG_START_LOCAL:
             case DBG_START_LOCAL_EXTENDED: {
                 uint32_t register_num = decode_uleb128(ptr);
-                uint32_t name_idx = decode_uleb128(ptr);
-                uint32_t type_idx = decode_uleb128(ptr);
-                uint32_t sig_idx = decode_uleb128(ptr);
-
-                std::string name = (name_idx != 0 && name_idx <= strings_.size()) ? strings_[name_idx - 1] : "";
-                std::string type = (type_idx != 0 && type_idx <= type_names_.size()) ? type_names_[type_idx - 1] : "";
-                std::string signature = (sig_idx != 0 && sig_idx <= strings_.size()) ? strings_[sig_idx - 1] : "";
+                LocalState state;
+                state.name_idx = string_id(decode_uleb128(ptr));
+                state.type_idx = type_id(decode_uleb128(ptr));
+                if (opcode == DBG_START_LOCAL_EXTENDED) {
+                    state.signature_idx = string_id(decode_uleb128(ptr));
+                }
+                state.kind = LocalKind::START;
 
                 if (register_num < locals.size()) {
-                    locals[register_num] = {name, type, signature, LocalKind::START};
+                    locals[register_num] = state;
                 }
-
-                auto item = std::make_unique<StartLocalItem>(address, register_num, name, type, signature);
-                code.debug_items.push_back(std::move(item));
+                add_local(DebugItem::START_LOCAL, register_num, state);
                 break;
             }
 
@@ -894,19 +1090,10 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
                     replace_entry = (locals[register_num].kind != LocalKind::END);
                 }
 
-                LocalState comment_state = replace_entry ? previous_state : LocalState{};
-
-                auto item = std::make_unique<EndLocalItem>(address, register_num,
-                                                           comment_state.name,
-                                                           comment_state.type_descriptor,
-                                                           comment_state.signature);
-                code.debug_items.push_back(std::move(item));
+                add_local(DebugItem::END_LOCAL, register_num, replace_entry ? previous_state : empty_state);
 
                 if (replace_entry && register_num < locals.size()) {
-                    locals[register_num] = {previous_state.name,
-                                            previous_state.type_descriptor,
-                                            previous_state.signature,
-                                            LocalKind::END};
+                    locals[register_num].kind = LocalKind::END;
                 }
                 break;
             }
@@ -918,38 +1105,26 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
                     restart_state = locals[register_num];
                 }
 
-                auto restart_item = std::make_unique<RestartLocalItem>(address, register_num,
-                                                                        restart_state.name,
-                                                                        restart_state.type_descriptor,
-                                                                        restart_state.signature);
-                code.debug_items.push_back(std::move(restart_item));
+                add_local(DebugItem::RESTART_LOCAL, register_num, restart_state);
 
                 if (register_num < locals.size()) {
-                    locals[register_num] = {restart_state.name,
-                                            restart_state.type_descriptor,
-                                            restart_state.signature,
-                                            LocalKind::RESTART};
+                    locals[register_num].kind = LocalKind::RESTART;
                 }
                 break;
             }
 
-            case DBG_SET_PROLOGUE_END: {
-                auto prologue_item = std::make_unique<PrologueEndItem>(address);
-                code.debug_items.push_back(std::move(prologue_item));
+            case DBG_SET_PROLOGUE_END:
+                add_item(DebugItem::PROLOGUE_END);
                 break;
-            }
 
-            case DBG_SET_EPILOGUE_BEGIN: {
-                auto epilogue_item = std::make_unique<EpilogueBeginItem>(address);
-                code.debug_items.push_back(std::move(epilogue_item));
+            case DBG_SET_EPILOGUE_BEGIN:
+                add_item(DebugItem::EPILOGUE_BEGIN);
                 break;
-            }
 
             case DBG_SET_FILE: {
-                uint32_t file_name_idx = decode_uleb128(ptr);
-                if (file_name_idx != 0 && file_name_idx <= strings_.size()) {
-                    auto source_item = std::make_unique<SetSourceFileItem>(address, strings_[file_name_idx - 1]);
-                    code.debug_items.push_back(std::move(source_item));
+                uint32_t file_name_idx = string_id(decode_uleb128(ptr));
+                if (file_name_idx != NO_INDEX) {
+                    add_item(DebugItem::SET_SOURCE_FILE).name_idx = file_name_idx;
                 }
                 break;
             }
@@ -964,8 +1139,7 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
                     address += addr_diff;
 
                     if (line >= 0 && line < 65536) {
-                        auto item = std::make_unique<LineNumberItem>(address, static_cast<uint32_t>(line));
-                        code.debug_items.push_back(std::move(item));
+                        add_item(DebugItem::LINE_NUMBER).line_number = static_cast<uint32_t>(line);
                     }
                 } else {
                     return;
@@ -975,74 +1149,63 @@ void DexFile::parse_debug_info(uint32_t debug_info_off, DexCode& code, const Dex
     }
 }
 
-void DexFile::add_member_classes_annotation(DexClass& dex_class) {
-    // Look for inner classes that match this class
-    std::vector<std::string> member_classes;
-    std::string base_name = dex_class.class_name;
-    
-    // Remove L and ; from class name if present
-    if (base_name.length() > 2 && base_name[0] == 'L' && base_name.back() == ';') {
-        base_name = base_name.substr(1, base_name.length() - 2);
-    }
-    
-    // Look for classes that start with this class name + "$"
-    for (const auto& other_class : classes_) {
-        std::string other_name = other_class.class_name;
-        if (other_name.length() > 2 && other_name[0] == 'L' && other_name.back() == ';') {
-            other_name = other_name.substr(1, other_name.length() - 2);
-        }
-        
-        if (other_name.find(base_name + "$") == 0 && other_name != base_name) {
-            member_classes.push_back("L" + other_name + ";");
+void DexFile::add_member_classes_annotation(DexClass& dex_class) const {
+    static constexpr std::string_view MEMBER_CLASSES = "Ldalvik/annotation/MemberClasses;";
+    for (const auto& annotation : dex_class.annotations) {
+        if (annotation.type == MEMBER_CLASSES) {
+            return; // The DEX file already lists them
         }
     }
-    
-    // Add MemberClasses annotation if we found any
-    if (!member_classes.empty()) {
-        // Sort member classes: numeric suffixes first (1, 2, 3...), then alphabetic (a, b, c...)
-        std::sort(member_classes.begin(), member_classes.end(), [](const std::string& a, const std::string& b) {
-            // Extract suffix after last '$'
-            auto pos_a = a.rfind('$');
-            auto pos_b = b.rfind('$');
-            
-            if (pos_a != std::string::npos && pos_b != std::string::npos) {
-                std::string suffix_a = a.substr(pos_a + 1);
-                std::string suffix_b = b.substr(pos_b + 1);
-                
-                // Remove trailing ';' if present
-                if (suffix_a.back() == ';') suffix_a.pop_back();
-                if (suffix_b.back() == ';') suffix_b.pop_back();
-                
-                // Check if both are numeric
-                bool is_numeric_a = !suffix_a.empty() && std::all_of(suffix_a.begin(), suffix_a.end(), ::isdigit);
-                bool is_numeric_b = !suffix_b.empty() && std::all_of(suffix_b.begin(), suffix_b.end(), ::isdigit);
-                
-                if (is_numeric_a && is_numeric_b) {
-                    return std::stoi(suffix_a) < std::stoi(suffix_b);
-                } else if (is_numeric_a && !is_numeric_b) {
-                    return true; // numeric comes before alphabetic
-                } else if (!is_numeric_a && is_numeric_b) {
-                    return false; // alphabetic comes after numeric
-                } else {
-                    return suffix_a < suffix_b; // both alphabetic, sort alphabetically
-                }
+
+    // Member classes are every class named "<this class>$...", one run of the sorted index
+    std::string_view descriptor = dex_class.class_name;
+    if (descriptor.size() < 3 || descriptor.front() != 'L' || descriptor.back() != ';') {
+        return;
+    }
+    std::string prefix(descriptor.substr(0, descriptor.size() - 1));
+    prefix += '$';
+    std::vector<uint32_t> members = find_classes_with_prefix(prefix);
+    if (members.empty()) {
+        return;
+    }
+
+    // Numeric suffixes first, by value (1, 2, ... 10), then the rest alphabetically
+    auto suffix = [this](uint32_t index) {
+        std::string_view name = class_descriptor(index);
+        name.remove_suffix(1);
+        return name.substr(name.rfind('$') + 1);
+    };
+    auto is_numeric = [](std::string_view text) {
+        return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+    };
+    std::stable_sort(members.begin(), members.end(), [&](uint32_t a, uint32_t b) {
+        std::string_view suffix_a = suffix(a);
+        std::string_view suffix_b = suffix(b);
+        bool numeric_a = is_numeric(suffix_a);
+        bool numeric_b = is_numeric(suffix_b);
+        if (numeric_a != numeric_b) {
+            return numeric_a;
+        }
+        if (numeric_a) {
+            suffix_a.remove_prefix(std::min(suffix_a.find_first_not_of('0'), suffix_a.size()));
+            suffix_b.remove_prefix(std::min(suffix_b.find_first_not_of('0'), suffix_b.size()));
+            if (suffix_a.size() != suffix_b.size()) {
+                return suffix_a.size() < suffix_b.size();
             }
-            
-            return a < b; // fallback to string comparison
-        });
-        
-        DexAnnotation annotation;
-        annotation.type = "Ldalvik/annotation/MemberClasses;";
-        
-        for (const auto& member : member_classes) {
-            annotation.elements.push_back({"", member});
         }
-        
-        dex_class.annotations.push_back(annotation);
+        return suffix_a < suffix_b;
+    });
+
+    DexAnnotation& annotation = dex_class.annotations.emplace_back(dex_class.annotations.get_allocator().resource());
+    annotation.type = MEMBER_CLASSES;
+    annotation.visibility = VISIBILITY_SYSTEM;
+    annotation.elements.reserve(members.size());
+    for (uint32_t member : members) {
+        annotation.elements.emplace_back(std::string_view(), class_descriptor(member));
     }
 }
 
-bool DexFile::parse_annotations_directory(uint32_t annotations_off, DexClass& dex_class) {
+bool DexFile::parse_annotations_directory(uint32_t annotations_off, DexClass& dex_class) const {
     if (annotations_off >= file_data_.size()) {
         return false;
     }
@@ -1102,19 +1265,19 @@ bool DexFile::parse_annotations_directory(uint32_t annotations_off, DexClass& de
     return true;
 }
 
-bool DexFile::parse_field_annotations(uint32_t annotations_off, uint32_t field_idx, DexField& field) {
+bool DexFile::parse_field_annotations(uint32_t annotations_off, uint32_t field_idx, DexField& field) const {
     return parse_annotation_set(annotations_off, field.annotations);
 }
 
-bool DexFile::parse_method_annotations(uint32_t annotations_off, uint32_t method_idx, DexMethod& method) {
+bool DexFile::parse_method_annotations(uint32_t annotations_off, uint32_t method_idx, DexMethod& method) const {
     return parse_annotation_set(annotations_off, method.annotations);
 }
 
-bool DexFile::parse_class_annotations(uint32_t annotations_off, DexClass& dex_class) {
+bool DexFile::parse_class_annotations(uint32_t annotations_off, DexClass& dex_class) const {
     return parse_annotation_set(annotations_off, dex_class.annotations);
 }
 
-bool DexFile::parse_annotation_set(uint32_t annotations_off, std::vector<DexAnnotation>& annotations) {
+bool DexFile::parse_annotation_set(uint32_t annotations_off, std::pmr::vector<DexAnnotation>& annotations) const {
     if (annotations_off >= file_data_.size()) {
         return false;
     }
@@ -1127,16 +1290,16 @@ bool DexFile::parse_annotation_set(uint32_t annotations_off, std::vector<DexAnno
         const DexAnnotationOffItem* off_item = reinterpret_cast<const DexAnnotationOffItem*>(ptr);
         ptr += sizeof(DexAnnotationOffItem);
         
-        DexAnnotation annotation;
-        if (parse_annotation_item(off_item->annotation_off, annotation)) {
-            annotations.push_back(std::move(annotation));
+        DexAnnotation& annotation = annotations.emplace_back(annotations.get_allocator().resource());
+        if (!parse_annotation_item(off_item->annotation_off, annotation)) {
+            annotations.pop_back();
         }
     }
     
     return true;
 }
 
-bool DexFile::parse_annotation_item(uint32_t annotation_off, DexAnnotation& annotation) {
+bool DexFile::parse_annotation_item(uint32_t annotation_off, DexAnnotation& annotation) const {
     if (annotation_off >= file_data_.size()) {
         return false;
     }
@@ -1151,7 +1314,7 @@ bool DexFile::parse_annotation_item(uint32_t annotation_off, DexAnnotation& anno
     return parse_encoded_annotation(ptr, annotation);
 }
 
-bool DexFile::parse_encoded_annotation(const uint8_t*& ptr, DexAnnotation& annotation) {
+bool DexFile::parse_encoded_annotation(const uint8_t*& ptr, DexAnnotation& annotation) const {
     // Parse type_idx (ULEB128)
     uint32_t type_idx = decode_uleb128(ptr);
     if (type_idx < type_names_.size()) {
@@ -1165,22 +1328,22 @@ bool DexFile::parse_encoded_annotation(const uint8_t*& ptr, DexAnnotation& annot
     for (uint32_t i = 0; i < size; ++i) {
         // Parse name_idx (ULEB128)
         uint32_t name_idx = decode_uleb128(ptr);
-        std::string element_name;
+        std::string_view element_name;
         if (name_idx < strings_.size()) {
-            element_name = strings_[name_idx];
+            element_name = strings_.get(name_idx);
         }
 
         // Parse the encoded value directly - don't assume it's an array
         std::string value = parse_encoded_value(ptr);
 
-        // Store the name-value pair
-        annotation.elements.push_back({element_name, value});
+        // Store the name-value pair; the value is copied into the class's arena
+        annotation.elements.emplace_back(element_name, value);
     }
 
     return true;
 }
 
-std::vector<std::string> DexFile::parse_encoded_array(const uint8_t*& ptr) {
+std::vector<std::string> DexFile::parse_encoded_array(const uint8_t*& ptr) const {
     uint8_t value_type = *ptr++;
     uint8_t value_arg = (value_type & 0xe0) >> 5;
     value_type &= 0x1f;
@@ -1203,7 +1366,7 @@ std::vector<std::string> DexFile::parse_encoded_array(const uint8_t*& ptr) {
     return array_values;
 }
 
-std::string DexFile::parse_encoded_value(const uint8_t*& ptr) {
+std::string DexFile::parse_encoded_value(const uint8_t*& ptr) const {
     uint8_t value_type = *ptr++;
     uint8_t value_arg = (value_type & 0xe0) >> 5;
     value_type &= 0x1f;
@@ -1216,69 +1379,7 @@ std::string DexFile::parse_encoded_value(const uint8_t*& ptr) {
                 string_idx |= static_cast<uint32_t>(*ptr++) << (i * 8);
             }
             
-            if (string_idx < strings_.size()) {
-                std::string str = strings_[string_idx];
-                // Escape control characters and backslashes for smali format
-                std::string result;
-                result.reserve(str.size() * 2);
-                for (size_t i = 0; i < str.size(); ++i) {
-                    char ch = str[i];
-
-                    if (ch == '\r') {
-                        result += "\\r";
-                        if (i + 1 < str.size() && str[i + 1] == '\n') {
-                            result += "\\n";
-                            ++i;
-                        }
-                        continue;
-                    }
-                    if (ch == '\n') {
-                        result += "\\n";
-                        continue;
-                    }
-                    if (ch == '\t') {
-                        result += "\\t";
-                        continue;
-                    }
-
-                    if (ch == '\\' && i + 1 < str.size() && str[i + 1] == 'u' && i + 5 < str.size()) {
-                        bool is_unicode = true;
-                        for (size_t j = 2; j <= 5; ++j) {
-                            char hex = str[i + j];
-                            if (!((hex >= '0' && hex <= '9') ||
-                                  (hex >= 'a' && hex <= 'f') ||
-                                  (hex >= 'A' && hex <= 'F'))) {
-                                is_unicode = false;
-                                break;
-                            }
-                        }
-                        if (is_unicode) {
-                            result += '\\';
-                            result += 'u';
-                            result.append(str, i + 2, 4);
-                            i += 5;
-                            continue;
-                        }
-                    }
-
-                    if (ch == '"') {
-                        result += "\\\"";
-                        continue;
-                    }
-                    if (ch == '\'') {
-                        result += "\\'";
-                        continue;
-                    }
-                    if (ch == '\\') {
-                        result += "\\\\";
-                        continue;
-                    }
-
-                    result += ch;
-                }
-                return "\"" + result + "\"";
-            }
-            return "\"\"";
+            return std::string(get_string_literal(string_idx));
         }
         
         case 0x00: { // VALUE_BYTE
@@ -1340,13 +1441,29 @@ std::string DexFile::parse_encoded_value(const uint8_t*& ptr) {
             return std::to_string(value) + "L";
         }
 
+        case 0x15: { // VALUE_METHOD_TYPE
+            uint32_t proto_idx = 0;
+            for (int i = 0; i <= value_arg; ++i) {
+                proto_idx |= static_cast<uint32_t>(*ptr++) << (i * 8);
+            }
+            return get_proto(proto_idx);
+        }
+
+        case 0x16: { // VALUE_METHOD_HANDLE
+            uint32_t method_handle_idx = 0;
+            for (int i = 0; i <= value_arg; ++i) {
+                method_handle_idx |= static_cast<uint32_t>(*ptr++) << (i * 8);
+            }
+            return get_method_handle(method_handle_idx);
+        }
+
         case 0x18: { // VALUE_TYPE (class type)
             uint32_t type_idx = 0;
             for (int i = 0; i <= value_arg; ++i) {
                 type_idx |= static_cast<uint32_t>(*ptr++) << (i * 8);
             }
             if (type_idx < type_names_.size()) {
-                return type_names_[type_idx];
+                return std::string(type_names_[type_idx]);
             }
             return "UnknownType@" + std::to_string(type_idx);
         }
@@ -1356,7 +1473,7 @@ std::string DexFile::parse_encoded_value(const uint8_t*& ptr) {
             for (int i = 0; i <= value_arg; ++i) {
                 field_idx |= static_cast<uint32_t>(*ptr++) << (i * 8);
             }
-            return ".enum " + get_field_reference(field_idx);
+            return ".enum " + std::string(get_field_reference(field_idx));
         }
 
         case 0x1c: { // VALUE_ARRAY
@@ -1393,7 +1510,7 @@ std::string DexFile::parse_encoded_value(const uint8_t*& ptr) {
     }
 }
 
-bool DexFile::parse_static_values(uint32_t static_values_off, DexClass& dex_class) {
+bool DexFile::parse_static_values(uint32_t static_values_off, DexClass& dex_class) const {
     if (static_values_off >= file_data_.size()) {
         return false;
     }
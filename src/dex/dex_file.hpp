@@ -1,11 +1,15 @@
 #pragma once
 
 #include "dex_structures.hpp"
+#include "mapped_file.hpp"
+#include "interned_string_table.hpp"
+#include "string_table.hpp"
 #include <string>
 #include <string_view>
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <optional>
 
 // DEX file format constants (matching AOSP definitions)
 constexpr uint32_t DEX_FILE_MAGIC_SIZE = 8;
@@ -44,72 +48,144 @@ struct DexMethod;
 struct DexField;
 struct DexInstruction;
 
+// Parts of a class the reader decodes. A front-end turns off what it will
+// not print, so that part of the file is never read.
+struct DexDecodeFeatures {
+    bool debug_info = true;
+    bool annotations = true;
+    bool static_values = true;
+};
+
 class DexFile {
 public:
     static std::unique_ptr<DexFile> open(const std::string& filename);
+    // DEX image inside a larger mapping (e.g. a stored APK entry); the mapping is kept alive
+    static std::unique_ptr<DexFile> open(std::shared_ptr<const MappedFile> backing, ByteView data);
+    // DEX image already in memory (e.g. an inflated APK entry)
+    static std::unique_ptr<DexFile> open(std::vector<uint8_t> data);
     
     ~DexFile();
     
     // Accessors
     const DexHeader& header() const { return *header_; }
-    const std::vector<DexClass>& classes() const { return classes_; }
+    
+    // class_defs are only indexed at open time; a DexClass is built on request
+    uint32_t class_count() const { return header_->class_defs_size; }
+    const DexClassDef& class_def(uint32_t index) const;
+    std::string_view class_descriptor(uint32_t index) const;
+    DexClassSummary summarize_class(uint32_t index) const;
+    
+    // Lookups through the descriptor-sorted class index
+    std::optional<uint32_t> find_class(std::string_view descriptor) const;
+    std::vector<uint32_t> find_classes_with_prefix(std::string_view prefix) const;
+    
+    // Parses one class, minus anything turned off in the decode features.
+    // The class graph is allocated from `resource`, normally a ClassArena.
+    // Safe to call from several threads at once.
+    ArenaPtr<DexClass> load_class(uint32_t index,
+                                  std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    
+    void set_decode_features(const DexDecodeFeatures& features) { features_ = features; }
+    const DexDecodeFeatures& decode_features() const { return features_; }
+    
+    // Debug info is not part of a loaded class; the writer decodes each
+    // method's into `items` (cleared first) as it renders the method
+    void decode_debug_info(const DexMethod& method, std::pmr::vector<DebugItem>& items) const;
     
     // String retrieval
-    std::string get_string(uint32_t string_idx) const;
-    std::string get_type_name(uint32_t type_idx) const;
-    std::string get_method_name(uint32_t method_idx) const;
-    std::string get_field_name(uint32_t field_idx) const;
+    // Out-of-range indices yield an empty string
+    // Views stay valid for the lifetime of the DexFile
+    std::string_view get_string(uint32_t string_idx) const;
+    std::string_view get_type_name(uint32_t type_idx) const;
+    std::string_view get_method_name(uint32_t method_idx) const;
+    std::string_view get_field_name(uint32_t field_idx) const;
+    const std::string& get_proto(uint32_t proto_idx) const;
 
     // String count getter
     uint32_t get_string_count() const { return strings_.size(); }
     
-    // Reference formatting (for smali output)
-    std::string get_method_reference(uint32_t method_idx) const;
-    std::string get_field_reference(uint32_t field_idx) const;
+    // Reference formatting (for smali output). Built once per id and shared
+    // by all threads; the views stay valid for the lifetime of the DexFile.
+    std::string_view get_method_reference(uint32_t method_idx) const;
+    std::string_view get_field_reference(uint32_t field_idx) const;
+    // A string as a quoted, escaped smali literal, e.g. "\"a\\tb\""
+    std::string_view get_string_literal(uint32_t string_idx) const;
+    
+    // DEX 038+ references, rendered the way baksmali does, e.g.
+    // "invoke-static@Lfoo;->bar()V" and "call_site_0(\"run\", ()V)@Lfoo;->bootstrap(...)"
+    std::string get_method_handle(uint32_t method_handle_idx) const;
+    std::string get_call_site(uint32_t call_site_idx) const;
+    
+    struct ReferenceCacheStats {
+        InternedStringTable::Stats methods;
+        InternedStringTable::Stats fields;
+        InternedStringTable::Stats literals;
+    };
+    ReferenceCacheStats reference_cache_stats() const;
     
 private:
     DexFile() = default;
     
+    bool load();
     bool parse_header();
+    void apply_access_hints();
     bool parse_string_ids();
     bool parse_type_ids();
     bool parse_proto_ids();
     bool parse_field_ids();
     bool parse_method_ids();
     bool parse_class_defs();
+    void parse_map_list();
+    std::string build_method_reference(uint32_t method_idx) const;
+    std::string build_field_reference(uint32_t field_idx) const;
+    std::string build_string_literal(uint32_t string_idx) const;
+    void build_class_index();
     
     // Helper methods for detailed parsing
-    bool parse_interfaces(uint32_t interfaces_off, DexClass& dex_class);
-    bool parse_class_data(uint32_t class_data_off, DexClass& dex_class);
-    bool parse_encoded_fields(const uint8_t*& ptr, uint32_t count, std::vector<DexField>& fields, bool is_static);
-    bool parse_encoded_methods(const uint8_t*& ptr, uint32_t count, std::vector<DexMethod>& methods, bool is_direct);
-    std::unique_ptr<DexCode> parse_code_item(uint32_t code_off, DexMethod* method_context = nullptr);
-    void parse_instructions(const uint16_t* insns, uint32_t insns_size, std::vector<DexInstruction>& instructions);
-    void parse_debug_info(uint32_t debug_info_off, DexCode& code, const DexMethod* method_context);
-    void add_member_classes_annotation(DexClass& dex_class);
-    bool parse_static_values(uint32_t static_values_off, DexClass& dex_class);
+    bool parse_interfaces(uint32_t interfaces_off, DexClass& dex_class) const;
+    bool parse_class_data(uint32_t class_data_off, DexClass& dex_class) const;
+    bool parse_encoded_fields(const uint8_t*& ptr, uint32_t count, std::pmr::vector<DexField>& fields, bool is_static) const;
+    bool parse_encoded_methods(const uint8_t*& ptr, uint32_t count, std::pmr::vector<DexMethod>& methods, bool is_direct) const;
+    ArenaPtr<DexCode> parse_code_item(uint32_t code_off, std::pmr::memory_resource* resource) const;
+    void parse_instructions(const uint16_t* insns, uint32_t insns_size, DexCode& code) const;
+    void parse_tries(const uint8_t* code_item, DexCode& code) const;
+    void parse_debug_info(uint32_t debug_info_off, const DexCode& code, const DexMethod* method_context,
+                          std::pmr::vector<DebugItem>& items) const;
+    void add_member_classes_annotation(DexClass& dex_class) const;
+    bool parse_static_values(uint32_t static_values_off, DexClass& dex_class) const;
     
     // Annotation parsing methods
-    bool parse_annotations_directory(uint32_t annotations_off, DexClass& dex_class);
-    bool parse_field_annotations(uint32_t annotations_off, uint32_t field_idx, DexField& field);
-    bool parse_method_annotations(uint32_t annotations_off, uint32_t method_idx, DexMethod& method);
-    bool parse_class_annotations(uint32_t annotations_off, DexClass& dex_class);
-    bool parse_annotation_set(uint32_t annotations_off, std::vector<DexAnnotation>& annotations);
-    bool parse_annotation_item(uint32_t annotation_off, DexAnnotation& annotation);
-    bool parse_encoded_annotation(const uint8_t*& ptr, DexAnnotation& annotation);
-    std::string parse_encoded_value(const uint8_t*& ptr);
-    std::vector<std::string> parse_encoded_array(const uint8_t*& ptr);
-    
-    std::vector<uint8_t> file_data_;
+    bool parse_annotations_directory(uint32_t annotations_off, DexClass& dex_class) const;
+    bool parse_field_annotations(uint32_t annotations_off, uint32_t field_idx, DexField& field) const;
+    bool parse_method_annotations(uint32_t annotations_off, uint32_t method_idx, DexMethod& method) const;
+    bool parse_class_annotations(uint32_t annotations_off, DexClass& dex_class) const;
+    bool parse_annotation_set(uint32_t annotations_off, std::pmr::vector<DexAnnotation>& annotations) const;
+    bool parse_annotation_item(uint32_t annotation_off, DexAnnotation& annotation) const;
+    bool parse_encoded_annotation(const uint8_t*& ptr, DexAnnotation& annotation) const;
+    std::string parse_encoded_value(const uint8_t*& ptr) const;
+    std::vector<std::string> parse_encoded_array(const uint8_t*& ptr) const;
+    
+    std::shared_ptr<const MappedFile> mapping_;
+    std::vector<uint8_t> owned_data_;  // Backing store when not mapped
+    ByteView file_data_;  // View over mapping_ or owned_data_
     std::unique_ptr<DexHeader> header_;
-    std::vector<DexClass> classes_;
+    const DexClassDef* class_defs_ = nullptr;
+    std::vector<uint32_t> classes_by_descriptor_;  // class_def indices sorted by descriptor
+    DexDecodeFeatures features_;
     
     // String table
-    std::vector<std::string> strings_;
-    std::vector<std::string> type_names_;
-    std::vector<std::string> method_names_;
-    std::vector<std::string> field_names_;
+    DexStringTable strings_;
+    std::vector<std::string_view> type_names_;    // Views into strings_
+    std::vector<std::string_view> method_names_;
+    std::vector<std::string_view> field_names_;
     
     // Additional cached data
     std::vector<std::string> proto_signatures_;
+    const DexMethodHandleItem* method_handles_ = nullptr;
+    uint32_t method_handles_size_ = 0;
+    const uint32_t* call_site_ids_ = nullptr;
+    uint32_t call_site_ids_size_ = 0;
+    InternedStringTable method_references_;
+    InternedStringTable field_references_;
+    InternedStringTable string_literals_;
 };
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include "class_arena.hpp"
+#include "opcode_table.hpp"
 
 #pragma pack(push, 1)
 
@@ -34,6 +38,22 @@ struct DexHeader {
     uint32_t data_off;          // Offset of data section
 };
 
+// map_list entry describing one section of the file
+struct DexMapItem {
+    uint16_t type;              // Item type (DexMapItemType)
+    uint16_t unused;
+    uint32_t size;              // Count of items in the section
+    uint32_t offset;            // Offset of the section from the start of the file
+};
+
+// method_handle_item (DEX 038+)
+struct DexMethodHandleItem {
+    uint16_t method_handle_type;  // MethodHandleType
+    uint16_t unused1;
+    uint16_t field_or_method_id;
+    uint16_t unused2;
+};
+
 struct DexStringId {
     uint32_t string_data_off;   // Offset to string data
 };
@@ -101,11 +121,20 @@ struct DexCodeItem {
     // followed by instructions array in the file
 };
 
-// Forward declaration first
-struct DebugItem;
+// try_item, following the instructions (4-byte aligned)
+struct DexTryItem {
+    uint32_t start_addr;        // First covered code unit
+    uint16_t insn_count;        // Covered code units
+    uint16_t handler_off;       // Offset of the handler list in encoded_catch_handler_list
+};
+
+#pragma pack(pop)
 
 // Parsed code representation (for our use)
 struct DexCode {
+    explicit DexCode(std::pmr::memory_resource* resource)
+        : instructions(resource), tries(resource), catch_handlers(resource) {}
+
     uint16_t registers_size;    // Number of registers used by this code
     uint16_t ins_size;          // Number of words of incoming arguments
     uint16_t outs_size;         // Number of words of outgoing arguments
@@ -113,18 +142,62 @@ struct DexCode {
     uint32_t debug_info_off;    // Offset to debug info sequence
     uint32_t insns_size;        // Size of instruction array in 16-bit units
 
-    std::vector<struct DexInstruction> instructions; // Parsed instructions
-    std::vector<std::unique_ptr<DebugItem>> debug_items; // Debug information
+    const uint16_t* insns = nullptr;                 // Code units, inside the mapped file
+    std::pmr::vector<struct DexInstruction> instructions; // Decoded instructions, in address order
+    std::pmr::vector<struct DexTryBlock> tries;           // Sorted by start address
+    std::pmr::vector<struct DexCatchHandler> catch_handlers; // Handler lists, each decoded once and shared
+};
+
+// map_list item type codes (from AOSP)
+enum DexMapItemType : uint16_t {
+    TYPE_HEADER_ITEM = 0x0000,
+    TYPE_STRING_ID_ITEM = 0x0001,
+    TYPE_TYPE_ID_ITEM = 0x0002,
+    TYPE_PROTO_ID_ITEM = 0x0003,
+    TYPE_FIELD_ID_ITEM = 0x0004,
+    TYPE_METHOD_ID_ITEM = 0x0005,
+    TYPE_CLASS_DEF_ITEM = 0x0006,
+    TYPE_CALL_SITE_ID_ITEM = 0x0007,
+    TYPE_METHOD_HANDLE_ITEM = 0x0008,
+    TYPE_MAP_LIST = 0x1000,
+    TYPE_TYPE_LIST = 0x1001,
+    TYPE_CLASS_DATA_ITEM = 0x2000,
+    TYPE_CODE_ITEM = 0x2001,
+    TYPE_STRING_DATA_ITEM = 0x2002,
+    TYPE_DEBUG_INFO_ITEM = 0x2003
 };
 
-#pragma pack(pop)
-
 // High-level structures (not packed)
+// One decoded instruction. Fixed size and trivially copyable; which fields
+// are meaningful depends on `format`. Anything not captured here (payload
+// entries) is read from DexCode::insns at `address`.
 struct DexInstruction {
-    uint16_t opcode;
-    std::vector<uint32_t> operands;
-    uint32_t address;
-    std::string mnemonic;
+    uint32_t address = 0;           // Offset in 16-bit code units
+    uint32_t width = 0;             // Code units, including any payload data
+    uint8_t opcode = 0;
+    InstructionFormat format = InstructionFormat::UNUSED;
+    uint8_t register_count = 0;     // Register operands; the argument count for 3rc/4rcc
+    uint16_t registers[5] = {};     // vA, vB, vC... or the 35c argument list; 3rc keeps the first register
+    uint16_t proto_index = 0;       // 45cc/4rcc prototype
+    uint32_t index = 0;             // String, type, field, method... index; payload entry count
+    int64_t literal = 0;            // Literal value or signed branch offset; payload first key or element width
+};
+
+// One catch clause of a handler list
+struct DexCatchHandler {
+    static constexpr uint32_t CATCH_ALL = 0xFFFFFFFF;
+
+    uint32_t type_idx;          // Caught type, or CATCH_ALL
+    uint32_t address;           // Handler code address
+};
+
+// A try_item with its handler list resolved to a slice of DexCode::catch_handlers
+struct DexTryBlock {
+    uint32_t start_address;     // First covered code unit
+    uint32_t end_address;       // One past the last covered code unit
+    uint32_t last_address;      // Address of the last covered instruction
+    uint32_t handlers_begin;
+    uint32_t handlers_end;
 };
 
 // Debug info opcodes (from AOSP)
@@ -142,126 +215,64 @@ enum DebugInfoOpcode : uint8_t {
     DBG_FIRST_SPECIAL = 0x0a
 };
 
-// Debug items
+// One debug event. DexFile::decode_debug_info decodes a method's events into
+// a flat list (ClassDefinition::debug_items_) while the method is written.
+// Names, types and signatures stay DEX string/type ids and are resolved then.
 struct DebugItem {
-    enum Type { START_LOCAL, END_LOCAL, LINE_NUMBER, RESTART_LOCAL, PROLOGUE_END, EPILOGUE_BEGIN, SET_SOURCE_FILE } type;
-    uint32_t address;
-    int sort_order;
-};
-
-struct StartLocalItem : DebugItem {
-    uint32_t register_num;
-    std::string name;
-    std::string type_descriptor;
-    std::string signature;
+    static constexpr uint32_t NO_INDEX = 0xFFFFFFFF;
+    static constexpr uint32_t THIS_NAME = 0xFFFFFFFE;  // name_idx of the implicit "this" local
 
-    StartLocalItem(uint32_t addr, uint32_t reg, const std::string& n = "",
-                   const std::string& t = "", const std::string& s = "")
-        : register_num(reg), name(n), type_descriptor(t), signature(s) {
-        type = START_LOCAL;
-        address = addr;
-        sort_order = 1;
-    }
-};
-
-struct EndLocalItem : DebugItem {
-    uint32_t register_num;
-    std::string name;
-    std::string type_descriptor;
-    std::string signature;
-
-    EndLocalItem(uint32_t addr, uint32_t reg, const std::string& n = "",
-                 const std::string& t = "", const std::string& s = "")
-        : register_num(reg), name(n), type_descriptor(t), signature(s) {
-        type = END_LOCAL;
-        address = addr;
-        sort_order = 2;
-    }
-};
-
-struct LineNumberItem : DebugItem {
-    uint32_t line_number;
-
-    LineNumberItem(uint32_t addr, uint32_t line) : line_number(line) {
-        type = LINE_NUMBER;
-        address = addr;
-        sort_order = 0;
-    }
-};
-
-struct RestartLocalItem : DebugItem {
-    uint32_t register_num;
-    std::string name;
-    std::string type_descriptor;
-    std::string signature;
-
-    RestartLocalItem(uint32_t addr, uint32_t reg, const std::string& n = "",
-                     const std::string& t = "", const std::string& s = "")
-        : register_num(reg), name(n), type_descriptor(t), signature(s) {
-        type = RESTART_LOCAL;
-        address = addr;
-        sort_order = 0;
-    }
-};
+    enum Type : uint8_t { START_LOCAL, END_LOCAL, LINE_NUMBER, RESTART_LOCAL, PROLOGUE_END, EPILOGUE_BEGIN, SET_SOURCE_FILE };
 
-struct PrologueEndItem : DebugItem {
-    PrologueEndItem(uint32_t addr) {
-        type = PROLOGUE_END;
-        address = addr;
-        sort_order = 0;
-    }
-};
-
-struct EpilogueBeginItem : DebugItem {
-    EpilogueBeginItem(uint32_t addr) {
-        type = EPILOGUE_BEGIN;
-        address = addr;
-        sort_order = 0;
-    }
-};
-
-struct SetSourceFileItem : DebugItem {
-    std::string source_file;
-
-    SetSourceFileItem(uint32_t addr, const std::string& file) : source_file(file) {
-        type = SET_SOURCE_FILE;
-        address = addr;
-        sort_order = 0;
-    }
+    Type type;
+    uint32_t address;
+    uint32_t register_num = 0;          // Local's register
+    uint32_t line_number = 0;           // LINE_NUMBER only
+    uint32_t name_idx = NO_INDEX;       // String id of the local's name, or of the source file
+    uint32_t type_idx = NO_INDEX;       // Type id of the local's type
+    uint32_t signature_idx = NO_INDEX;  // String id of the local's generic signature
 };
 
-// Extend DexCode with debug information (now that DebugItem is defined)
-// We need to redefine the instructions and debug_items outside the struct due to C++ limitations
+// The class graph below is built in the memory resource passed to
+// DexFile::load_class, normally a worker's ClassArena. Names, types and
+// signatures are views into the DexFile and outlive the graph; only values
+// formatted while parsing are owned.
 
 // Simple annotation representation
 struct DexAnnotation {
-    std::string type;
-    uint8_t visibility;  // VISIBILITY_BUILD, VISIBILITY_RUNTIME, or VISIBILITY_SYSTEM
-    std::vector<std::pair<std::string, std::string>> elements;
+    explicit DexAnnotation(std::pmr::memory_resource* resource) : elements(resource) {}
+
+    std::string_view type;
+    uint8_t visibility = 0;  // VISIBILITY_BUILD, VISIBILITY_RUNTIME, or VISIBILITY_SYSTEM
+    std::pmr::vector<std::pair<std::string_view, std::pmr::string>> elements;
 };
 
 struct DexMethod {
-    uint32_t method_idx;
-    uint32_t access_flags;
-    std::unique_ptr<DexCode> code;
-    std::string name;
-    std::string signature;
-    std::string class_name;
+    explicit DexMethod(std::pmr::memory_resource* resource) : annotations(resource) {}
+
+    uint32_t method_idx = 0;
+    uint32_t access_flags = 0;
+    ArenaPtr<DexCode> code;
+    std::string_view name;
+    std::string_view signature;
+    std::string_view class_name;
     
     // Method annotations
-    std::vector<DexAnnotation> annotations;
+    std::pmr::vector<DexAnnotation> annotations;
 };
 
 struct DexField {
-    uint32_t field_idx;
-    uint32_t access_flags;
-    std::string name;
-    std::string type;
-    std::string class_name;
-    std::string initial_value;  // For static final fields
+    explicit DexField(std::pmr::memory_resource* resource) : initial_value(resource), annotations(resource) {}
+
+    uint32_t field_idx = 0;
+    uint32_t access_flags = 0;
+    std::string_view name;
+    std::string_view type;
+    std::string_view class_name;
+    std::pmr::string initial_value;  // For static final fields
 
     // Field annotations
-    std::vector<DexAnnotation> annotations;
+    std::pmr::vector<DexAnnotation> annotations;
 };
 
 // DEX annotation structures (packed)
@@ -316,22 +327,29 @@ enum AnnotationVisibility : uint8_t {
 };
 
 struct DexClass {
-    uint32_t class_idx;
-    uint32_t access_flags;
-    std::string class_name;
-    std::string superclass_name;
-    std::vector<std::string> interfaces;
-    std::string source_file;
+    explicit DexClass(std::pmr::memory_resource* resource)
+        : interfaces(resource), static_fields(resource), instance_fields(resource),
+          direct_methods(resource), virtual_methods(resource), annotations(resource) {}
+
+    uint32_t class_idx = 0;
+    uint32_t access_flags = 0;
+    std::string_view class_name;
+    std::string_view superclass_name;
+    std::pmr::vector<std::string_view> interfaces;
+    std::string_view source_file;
     
-    std::vector<DexField> static_fields;
-    std::vector<DexField> instance_fields;
-    std::vector<DexMethod> direct_methods;
-    std::vector<DexMethod> virtual_methods;
+    std::pmr::vector<DexField> static_fields;
+    std::pmr::vector<DexField> instance_fields;
+    std::pmr::vector<DexMethod> direct_methods;
+    std::pmr::vector<DexMethod> virtual_methods;
     
     // Annotations
-    std::vector<DexAnnotation> annotations;
+    std::pmr::vector<DexAnnotation> annotations;
 };
 
-// Now we can complete DexCode with debug_items (after DebugItem is defined)
-// This is a global variable to add to existing DexCode instances
-// Actually, let's use a cleaner approach - we'll add the debug_items through a helper method
\ No newline at end of file
+// Size of a class as read straight from its class_data, without parsing it
+struct DexClassSummary {
+    uint32_t field_count = 0;
+    uint32_t method_count = 0;
+    uint64_t insns_size = 0;    // Total code units across all methods
+};
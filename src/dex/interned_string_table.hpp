@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Fixed-size table of lazily built strings, indexed by a DEX id.
+//
+// The first lookup of an index builds its string and publishes it with a
+// compare-and-swap; every later lookup is a single atomic load. Threads that
+// race on the same index may each build it, but only one copy is kept, so the
+// returned views stay valid for the lifetime of the table.
+class InternedStringTable {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    InternedStringTable() = default;
+    explicit InternedStringTable(size_t size) { reset(size); }
+
+    ~InternedStringTable() { clear(); }
+
+    InternedStringTable(const InternedStringTable&) = delete;
+    InternedStringTable& operator=(const InternedStringTable&) = delete;
+
+    void reset(size_t size) {
+        clear();
+        slots_ = std::make_unique<std::atomic<const std::string*>[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            slots_[i].store(nullptr, std::memory_order_relaxed);
+        }
+        size_ = size;
+    }
+
+    size_t size() const { return size_; }
+
+    // Returns the string for `index`, calling build(index) the first time
+    template <typename Builder>
+    std::string_view get(uint32_t index, Builder&& build) const {
+        const std::string* value = slots_[index].load(std::memory_order_acquire);
+        CounterShard& counters = counters_[counter_shard()];
+        if (value) {
+            counters.hits.fetch_add(1, std::memory_order_relaxed);
+            return *value;
+        }
+
+        counters.misses.fetch_add(1, std::memory_order_relaxed);
+        auto built = std::make_unique<std::string>(build(index));
+        const std::string* expected = nullptr;
+        if (slots_[index].compare_exchange_strong(expected, built.get(),
+                                                  std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return *built.release();
+        }
+        return *expected; // Another thread won; ours is discarded
+    }
+
+    Stats stats() const {
+        Stats result;
+        for (const CounterShard& counters : counters_) {
+            result.hits += counters.hits.load(std::memory_order_relaxed);
+            result.misses += counters.misses.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+private:
+    // Hit and miss counts are split across cache lines, one per thread (up to
+    // COUNTER_SHARDS threads), so that counting does not make every lookup
+    // write to one shared line
+    static constexpr size_t COUNTER_SHARDS = 16;
+
+    struct alignas(64) CounterShard {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    static size_t counter_shard() {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+        return shard;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < size_; ++i) {
+            delete slots_[i].load(std::memory_order_relaxed);
+        }
+        slots_.reset();
+        size_ = 0;
+    }
+
+    std::unique_ptr<std::atomic<const std::string*>[]> slots_;
+    size_t size_ = 0;
+    mutable CounterShard counters_[COUNTER_SHARDS];
+};
@@ -0,0 +1,94 @@
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& filename) {
+    auto file = std::unique_ptr<MappedFile>(new MappedFile());
+
+#if !defined(_WIN32)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open file: " << filename << std::endl;
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            file->data_ = static_cast<const uint8_t*>(addr);
+            file->size_ = static_cast<size_t>(st.st_size);
+            file->mapped_ = true;
+        }
+    }
+    ::close(fd);
+
+    if (file->mapped_) {
+        return file;
+    }
+#endif
+
+    // Buffered fallback (non-regular files, platforms without mmap)
+    std::ifstream input(filename, std::ios::binary | std::ios::ate);
+    if (!input.is_open()) {
+        std::cerr << "Error: Cannot open file: " << filename << std::endl;
+        return nullptr;
+    }
+
+    auto size = input.tellg();
+    input.seekg(0, std::ios::beg);
+
+    file->buffer_.resize(static_cast<size_t>(size));
+    if (!input.read(reinterpret_cast<char*>(file->buffer_.data()), size)) {
+        std::cerr << "Error: Cannot read file: " << filename << std::endl;
+        return nullptr;
+    }
+
+    file->data_ = file->buffer_.data();
+    file->size_ = file->buffer_.size();
+    return file;
+}
+
+MappedFile::~MappedFile() {
+#if !defined(_WIN32)
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+}
+
+void MappedFile::advise(size_t offset, size_t length, Access access) const {
+#if !defined(_WIN32)
+    if (!mapped_ || offset >= size_ || length == 0) {
+        return;
+    }
+
+    // madvise() requires a page-aligned start address
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t aligned_offset = offset - (offset % page_size);
+    size_t end = std::min(offset + length, size_);
+
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case Access::NORMAL: advice = MADV_NORMAL; break;
+        case Access::SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+        case Access::RANDOM: advice = MADV_RANDOM; break;
+        case Access::WILLNEED: advice = MADV_WILLNEED; break;
+    }
+
+    // Hints are best-effort; a failure only costs performance
+    madvise(const_cast<uint8_t*>(data_) + aligned_offset, end - aligned_offset, advice);
+#else
+    (void)offset;
+    (void)length;
+    (void)access;
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Non-owning view over a contiguous range of bytes
+class ByteView {
+public:
+    ByteView() = default;
+    ByteView(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Read-only file contents, memory-mapped where the platform allows it.
+// Falls back to reading the file into a heap buffer when mapping fails.
+class MappedFile {
+public:
+    // Expected access pattern for a byte range, forwarded to madvise()
+    enum class Access {
+        NORMAL,
+        SEQUENTIAL,
+        RANDOM,
+        WILLNEED
+    };
+
+    static std::unique_ptr<MappedFile> open(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    ByteView view() const { return ByteView(data_, size_); }
+    bool is_mapped() const { return mapped_; }
+
+    // Hint the kernel about how a range will be read. No-op for buffered files.
+    void advise(size_t offset, size_t length, Access access) const;
+
+private:
+    MappedFile() = default;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> buffer_;  // Only used when the file could not be mapped
+};
@@ -0,0 +1,147 @@
+#include "method_labels.hpp"
+#include "dex_structures.hpp"
+#include "dalvik_opcodes.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t UNION = LABEL_KIND_COUNT;
+
+constexpr std::string_view LABEL_PREFIXES[LABEL_KIND_COUNT] = {
+    ":array_", ":catch_", ":catchall_", ":cond_", ":goto_", ":pswitch_", ":pswitch_data_",
+    ":sswitch_", ":sswitch_data_", ":try_end_", ":try_start_",
+};
+
+int32_t read_int32(const uint16_t* p) {
+    return static_cast<int32_t>(static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 16));
+}
+
+} // namespace
+
+MethodLabels::MethodLabels(const DexCode& code, bool sequential, std::pmr::memory_resource* resource)
+    : size_(code.insns_size + 1), words_((code.insns_size + 64) / 64), sequential_(sequential),
+      bits_(static_cast<size_t>(words_) * (LABEL_KIND_COUNT + 1), 0, resource), ranks_(resource),
+      switch_bases_(resource) {
+    for (const auto& instruction : code.instructions) {
+        if (format_layout(instruction.format).trailing != TrailingOperand::BRANCH) {
+            continue;
+        }
+        uint32_t target = static_cast<uint32_t>(instruction.address + instruction.literal);
+        mark(branch_kind(instruction.opcode), target);
+        if (instruction.opcode == OP_PACKED_SWITCH || instruction.opcode == OP_SPARSE_SWITCH) {
+            switch_bases_.emplace_back(target, instruction.address);
+        }
+    }
+    std::sort(switch_bases_.begin(), switch_bases_.end());
+
+    // Case targets are relative to the switch, so payloads go after every switch is known.
+    // Entry counts are clamped to the payload's width as in format_payload.
+    for (const auto& payload : code.instructions) {
+        const uint16_t* units = code.insns + payload.address;
+        uint32_t base = switch_address(payload.address);
+        if (payload.format == InstructionFormat::FORMAT_PACKED_SWITCH_PAYLOAD) {
+            uint32_t count = std::min<uint32_t>(payload.index, payload.width >= 4 ? (payload.width - 4) / 2 : 0);
+            for (uint32_t i = 0; i < count; ++i) {
+                mark(LabelKind::PSWITCH, base + static_cast<uint32_t>(read_int32(units + 4 + i * 2)));
+            }
+        } else if (payload.format == InstructionFormat::FORMAT_SPARSE_SWITCH_PAYLOAD) {
+            uint32_t count = std::min<uint32_t>(payload.index, payload.width >= 2 ? (payload.width - 2) / 4 : 0);
+            const uint16_t* targets = units + 2 + static_cast<size_t>(count) * 2;
+            for (uint32_t i = 0; i < count; ++i) {
+                mark(LabelKind::SSWITCH, base + static_cast<uint32_t>(read_int32(targets + i * 2)));
+            }
+        }
+    }
+
+    for (const auto& block : code.tries) {
+        mark(LabelKind::TRY_START, block.start_address);
+        mark(LabelKind::TRY_END, block.end_address);
+    }
+    for (const auto& handler : code.catch_handlers) {
+        mark(handler.type_idx == DexCatchHandler::CATCH_ALL ? LabelKind::CATCHALL : LabelKind::CATCH, handler.address);
+    }
+
+    if (sequential_) {
+        ranks_.resize(static_cast<size_t>(words_) * LABEL_KIND_COUNT);
+        for (uint32_t kind = 0; kind < LABEL_KIND_COUNT; ++kind) {
+            const uint64_t* words = &bits_[static_cast<size_t>(kind) * words_];
+            uint32_t* ranks = &ranks_[static_cast<size_t>(kind) * words_];
+            uint32_t total = 0;
+            for (uint32_t i = 0; i < words_; ++i) {
+                ranks[i] = total;
+                total += static_cast<uint32_t>(__builtin_popcountll(words[i]));
+            }
+        }
+    }
+}
+
+void MethodLabels::mark(LabelKind kind, uint32_t address) {
+    // Targets outside the method get no definition and keep their address name
+    if (address >= size_) {
+        return;
+    }
+    uint64_t bit = uint64_t(1) << (address % 64);
+    bits_[static_cast<size_t>(kind) * words_ + address / 64] |= bit;
+    if (kind != LabelKind::TRY_END) {
+        bits_[static_cast<size_t>(UNION) * words_ + address / 64] |= bit;
+    }
+}
+
+bool MethodLabels::has(LabelKind kind, uint32_t address) const {
+    return address < size_ && (bitmap(kind)[address / 64] >> (address % 64)) & 1;
+}
+
+uint32_t MethodLabels::next_address(uint32_t from) const {
+    if (from >= size_) {
+        return NONE;
+    }
+    const uint64_t* labelled = &bits_[static_cast<size_t>(UNION) * words_];
+    uint32_t word = from / 64;
+    uint64_t bits = labelled[word] & (~uint64_t(0) << (from % 64));
+    while (bits == 0) {
+        if (++word == words_) {
+            return NONE;
+        }
+        bits = labelled[word];
+    }
+    return word * 64 + static_cast<uint32_t>(__builtin_ctzll(bits));
+}
+
+void MethodLabels::write_labels_at(uint32_t address, OutputBuffer& out) const {
+    for (uint32_t kind = 0; kind < LABEL_KIND_COUNT; ++kind) {
+        if (kind != static_cast<uint32_t>(LabelKind::TRY_END) && has(static_cast<LabelKind>(kind), address)) {
+            out.append("    ");
+            append_label(static_cast<LabelKind>(kind), address, out);
+            out.append('\n');
+        }
+    }
+}
+
+uint32_t MethodLabels::rank(LabelKind kind, uint32_t address) const {
+    uint64_t below = bitmap(kind)[address / 64] & ((uint64_t(1) << (address % 64)) - 1);
+    return ranks_[static_cast<size_t>(kind) * words_ + address / 64] + static_cast<uint32_t>(__builtin_popcountll(below));
+}
+
+void MethodLabels::append_label(LabelKind kind, uint32_t address, OutputBuffer& out) const {
+    out.append(prefix(kind));
+    out.append_hex(sequential_ && has(kind, address) ? rank(kind, address) : address);
+}
+
+uint32_t MethodLabels::switch_address(uint32_t payload_address) const {
+    auto base = std::lower_bound(switch_bases_.begin(), switch_bases_.end(), std::make_pair(payload_address, uint32_t(0)));
+    return (base != switch_bases_.end() && base->first == payload_address) ? base->second : payload_address;
+}
+
+LabelKind MethodLabels::branch_kind(uint8_t opcode) {
+    switch (opcode) {
+        case OP_GOTO: case OP_GOTO_16: case OP_GOTO_32: return LabelKind::GOTO;
+        case OP_FILL_ARRAY_DATA: return LabelKind::ARRAY;
+        case OP_PACKED_SWITCH: return LabelKind::PSWITCH_DATA;
+        case OP_SPARSE_SWITCH: return LabelKind::SSWITCH_DATA;
+        default: return LabelKind::COND;
+    }
+}
+
+std::string_view MethodLabels::prefix(LabelKind kind) {
+    return LABEL_PREFIXES[static_cast<size_t>(kind)];
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "../formatter/output_buffer.hpp"
+
+struct DexCode;
+
+// Label kinds, in the order baksmali prints labels that share an address
+// (alphabetical by prefix)
+enum class LabelKind : uint8_t {
+    ARRAY,
+    CATCH,
+    CATCHALL,
+    COND,
+    GOTO,
+    PSWITCH,
+    PSWITCH_DATA,
+    SSWITCH,
+    SSWITCH_DATA,
+    TRY_END,
+    TRY_START,
+};
+
+constexpr uint32_t LABEL_KIND_COUNT = 11;
+
+// Every label target of one method, as one bitmap per label kind over the
+// method's code units.
+//
+// A single pass over the decoded instructions, switch payloads and try blocks
+// marks the targets. Whether an address carries a label is then a bit test,
+// and a sequential label's number is its rank in its kind's bitmap (a prefix
+// popcount), which matches baksmali's per-prefix numbering in address order.
+class MethodLabels {
+public:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    MethodLabels(const DexCode& code, bool sequential,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    bool has(LabelKind kind, uint32_t address) const;
+
+    // First address at or after `from` with a label to define, or NONE.
+    // :try_end_ labels are not included; they follow the last covered instruction.
+    uint32_t next_address(uint32_t from) const;
+
+    // Defines every label at `address`, one "    :name" line each
+    void write_labels_at(uint32_t address, OutputBuffer& out) const;
+
+    // A label reference, e.g. ":cond_1f", or ":cond_3" with sequential labels
+    void append_label(LabelKind kind, uint32_t address, OutputBuffer& out) const;
+
+    // Address of the packed-/sparse-switch that refers to the payload at
+    // `payload_address`; an unreferenced payload is resolved against itself
+    uint32_t switch_address(uint32_t payload_address) const;
+
+    static LabelKind branch_kind(uint8_t opcode);
+    static std::string_view prefix(LabelKind kind);
+
+private:
+    void mark(LabelKind kind, uint32_t address);
+    const uint64_t* bitmap(LabelKind kind) const { return &bits_[static_cast<size_t>(kind) * words_]; }
+    uint32_t rank(LabelKind kind, uint32_t address) const;
+
+    uint32_t size_;     // Code units plus one, so a try that covers the last instruction can end there
+    uint32_t words_;    // 64-bit words per bitmap
+    bool sequential_;
+
+    // LABEL_KIND_COUNT bitmaps, then the union of every kind but TRY_END
+    std::pmr::vector<uint64_t> bits_;
+    // Set bits before each word of each bitmap; only built for sequential labels
+    std::pmr::vector<uint32_t> ranks_;
+    // (payload address, switch address), sorted
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> switch_bases_;
+};
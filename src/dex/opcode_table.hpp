@@ -0,0 +1,276 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Dalvik instruction formats (from AOSP "Dalvik bytecode instruction formats").
+// The leading digit is the width in 16-bit code units.
+enum class InstructionFormat : uint8_t {
+    UNUSED,
+    FORMAT_10X, FORMAT_12X, FORMAT_11N, FORMAT_11X, FORMAT_10T,
+    FORMAT_20T, FORMAT_22X, FORMAT_21T, FORMAT_21S, FORMAT_21H, FORMAT_21C,
+    FORMAT_23X, FORMAT_22B, FORMAT_22T, FORMAT_22S, FORMAT_22C,
+    FORMAT_32X, FORMAT_30T, FORMAT_31T, FORMAT_31I, FORMAT_31C,
+    FORMAT_35C, FORMAT_3RC,
+    FORMAT_45CC, FORMAT_4RCC,
+    FORMAT_51L,
+    // Variable-width payloads that follow a nop opcode unit (ident 0x0100, 0x0200, 0x0300)
+    FORMAT_PACKED_SWITCH_PAYLOAD, FORMAT_SPARSE_SWITCH_PAYLOAD, FORMAT_ARRAY_PAYLOAD
+};
+
+// What the index operand of an instruction refers to
+enum class ReferenceKind : uint8_t {
+    NONE,
+    STRING,
+    TYPE,
+    FIELD,
+    METHOD,
+    CALL_SITE,
+    METHOD_HANDLE,
+    PROTO
+};
+
+struct OpcodeInfo {
+    const char* name;            // nullptr for unused opcodes
+    InstructionFormat format;
+    ReferenceKind reference;
+    uint8_t width;               // Code units, including the opcode unit
+    uint8_t min_api;             // First API level that accepts the opcode; informational only, decoding ignores it
+};
+
+constexpr uint8_t instruction_format_width(InstructionFormat format) {
+    switch (format) {
+        case InstructionFormat::FORMAT_20T: case InstructionFormat::FORMAT_22X:
+        case InstructionFormat::FORMAT_21T: case InstructionFormat::FORMAT_21S:
+        case InstructionFormat::FORMAT_21H: case InstructionFormat::FORMAT_21C:
+        case InstructionFormat::FORMAT_23X: case InstructionFormat::FORMAT_22B:
+        case InstructionFormat::FORMAT_22T: case InstructionFormat::FORMAT_22S:
+        case InstructionFormat::FORMAT_22C:
+            return 2;
+        case InstructionFormat::FORMAT_32X: case InstructionFormat::FORMAT_30T:
+        case InstructionFormat::FORMAT_31T: case InstructionFormat::FORMAT_31I:
+        case InstructionFormat::FORMAT_31C: case InstructionFormat::FORMAT_35C:
+        case InstructionFormat::FORMAT_3RC:
+            return 3;
+        case InstructionFormat::FORMAT_45CC: case InstructionFormat::FORMAT_4RCC:
+            return 4;
+        case InstructionFormat::FORMAT_51L:
+            return 5;
+        default:
+            return 1;
+    }
+}
+
+// How a format's operands are written: its registers, then at most one
+// literal, branch target or reference (plus a prototype for 45cc/4rcc)
+enum class RegisterOperands : uint8_t {
+    NONE,
+    FIXED,  // "vA, vB, ..."
+    LIST,   // "{vC, vD, ...}"
+    RANGE   // "{vCCCC .. vNNNN}"
+};
+
+enum class TrailingOperand : uint8_t {
+    NONE,
+    LITERAL,
+    BRANCH,
+    REFERENCE
+};
+
+struct FormatLayout {
+    RegisterOperands registers;
+    TrailingOperand trailing;
+    bool proto;
+};
+
+constexpr FormatLayout format_layout(InstructionFormat format) {
+    using F = InstructionFormat;
+    using R = RegisterOperands;
+    using T = TrailingOperand;
+    switch (format) {
+        case F::FORMAT_10T: case F::FORMAT_20T: case F::FORMAT_30T:
+            return {R::NONE, T::BRANCH, false};
+        case F::FORMAT_11N: case F::FORMAT_21S: case F::FORMAT_21H: case F::FORMAT_31I: case F::FORMAT_51L:
+        case F::FORMAT_22B: case F::FORMAT_22S:
+            return {R::FIXED, T::LITERAL, false};
+        case F::FORMAT_11X: case F::FORMAT_12X: case F::FORMAT_22X: case F::FORMAT_32X: case F::FORMAT_23X:
+            return {R::FIXED, T::NONE, false};
+        case F::FORMAT_21T: case F::FORMAT_22T: case F::FORMAT_31T:
+            return {R::FIXED, T::BRANCH, false};
+        case F::FORMAT_21C: case F::FORMAT_22C: case F::FORMAT_31C:
+            return {R::FIXED, T::REFERENCE, false};
+        case F::FORMAT_35C:
+            return {R::LIST, T::REFERENCE, false};
+        case F::FORMAT_3RC:
+            return {R::RANGE, T::REFERENCE, false};
+        case F::FORMAT_45CC:
+            return {R::LIST, T::REFERENCE, true};
+        case F::FORMAT_4RCC:
+            return {R::RANGE, T::REFERENCE, true};
+        default:
+            return {R::NONE, T::NONE, false};
+    }
+}
+
+namespace opcode_table_detail {
+
+constexpr std::array<OpcodeInfo, 256> build() {
+    using F = InstructionFormat;
+    using R = ReferenceKind;
+
+    std::array<OpcodeInfo, 256> table{};
+    for (auto& info : table) {
+        info = {nullptr, F::UNUSED, R::NONE, 1, 0};
+    }
+
+    auto set = [&table](uint8_t opcode, const char* name, F format, R reference = R::NONE, uint8_t min_api = 1) {
+        table[opcode] = {name, format, reference, instruction_format_width(format), min_api};
+    };
+
+    set(0x00, "nop", F::FORMAT_10X);
+    set(0x01, "move", F::FORMAT_12X);
+    set(0x02, "move/from16", F::FORMAT_22X);
+    set(0x03, "move/16", F::FORMAT_32X);
+    set(0x04, "move-wide", F::FORMAT_12X);
+    set(0x05, "move-wide/from16", F::FORMAT_22X);
+    set(0x06, "move-wide/16", F::FORMAT_32X);
+    set(0x07, "move-object", F::FORMAT_12X);
+    set(0x08, "move-object/from16", F::FORMAT_22X);
+    set(0x09, "move-object/16", F::FORMAT_32X);
+    set(0x0a, "move-result", F::FORMAT_11X);
+    set(0x0b, "move-result-wide", F::FORMAT_11X);
+    set(0x0c, "move-result-object", F::FORMAT_11X);
+    set(0x0d, "move-exception", F::FORMAT_11X);
+    set(0x0e, "return-void", F::FORMAT_10X);
+    set(0x0f, "return", F::FORMAT_11X);
+    set(0x10, "return-wide", F::FORMAT_11X);
+    set(0x11, "return-object", F::FORMAT_11X);
+    set(0x12, "const/4", F::FORMAT_11N);
+    set(0x13, "const/16", F::FORMAT_21S);
+    set(0x14, "const", F::FORMAT_31I);
+    set(0x15, "const/high16", F::FORMAT_21H);
+    set(0x16, "const-wide/16", F::FORMAT_21S);
+    set(0x17, "const-wide/32", F::FORMAT_31I);
+    set(0x18, "const-wide", F::FORMAT_51L);
+    set(0x19, "const-wide/high16", F::FORMAT_21H);
+    set(0x1a, "const-string", F::FORMAT_21C, R::STRING);
+    set(0x1b, "const-string/jumbo", F::FORMAT_31C, R::STRING);
+    set(0x1c, "const-class", F::FORMAT_21C, R::TYPE);
+    set(0x1d, "monitor-enter", F::FORMAT_11X);
+    set(0x1e, "monitor-exit", F::FORMAT_11X);
+    set(0x1f, "check-cast", F::FORMAT_21C, R::TYPE);
+    set(0x20, "instance-of", F::FORMAT_22C, R::TYPE);
+    set(0x21, "array-length", F::FORMAT_12X);
+    set(0x22, "new-instance", F::FORMAT_21C, R::TYPE);
+    set(0x23, "new-array", F::FORMAT_22C, R::TYPE);
+    set(0x24, "filled-new-array", F::FORMAT_35C, R::TYPE);
+    set(0x25, "filled-new-array/range", F::FORMAT_3RC, R::TYPE);
+    set(0x26, "fill-array-data", F::FORMAT_31T);
+    set(0x27, "throw", F::FORMAT_11X);
+    set(0x28, "goto", F::FORMAT_10T);
+    set(0x29, "goto/16", F::FORMAT_20T);
+    set(0x2a, "goto/32", F::FORMAT_30T);
+    set(0x2b, "packed-switch", F::FORMAT_31T);
+    set(0x2c, "sparse-switch", F::FORMAT_31T);
+
+    const char* const compares[] = {"cmpl-float", "cmpg-float", "cmpl-double", "cmpg-double", "cmp-long"};
+    for (uint8_t i = 0; i < 5; ++i) {
+        set(0x2d + i, compares[i], F::FORMAT_23X);
+    }
+
+    const char* const if_tests[] = {"if-eq", "if-ne", "if-lt", "if-ge", "if-gt", "if-le"};
+    const char* const if_zero_tests[] = {"if-eqz", "if-nez", "if-ltz", "if-gez", "if-gtz", "if-lez"};
+    for (uint8_t i = 0; i < 6; ++i) {
+        set(0x32 + i, if_tests[i], F::FORMAT_22T);
+        set(0x38 + i, if_zero_tests[i], F::FORMAT_21T);
+    }
+
+    // 0x44-0x51 arrays, 0x52-0x5f instance fields, 0x60-0x6d static fields
+    const char* const agets[] = {"aget", "aget-wide", "aget-object", "aget-boolean", "aget-byte", "aget-char", "aget-short"};
+    const char* const aputs[] = {"aput", "aput-wide", "aput-object", "aput-boolean", "aput-byte", "aput-char", "aput-short"};
+    const char* const igets[] = {"iget", "iget-wide", "iget-object", "iget-boolean", "iget-byte", "iget-char", "iget-short"};
+    const char* const iputs[] = {"iput", "iput-wide", "iput-object", "iput-boolean", "iput-byte", "iput-char", "iput-short"};
+    const char* const sgets[] = {"sget", "sget-wide", "sget-object", "sget-boolean", "sget-byte", "sget-char", "sget-short"};
+    const char* const sputs[] = {"sput", "sput-wide", "sput-object", "sput-boolean", "sput-byte", "sput-char", "sput-short"};
+    for (uint8_t i = 0; i < 7; ++i) {
+        set(0x44 + i, agets[i], F::FORMAT_23X);
+        set(0x4b + i, aputs[i], F::FORMAT_23X);
+        set(0x52 + i, igets[i], F::FORMAT_22C, R::FIELD);
+        set(0x59 + i, iputs[i], F::FORMAT_22C, R::FIELD);
+        set(0x60 + i, sgets[i], F::FORMAT_21C, R::FIELD);
+        set(0x67 + i, sputs[i], F::FORMAT_21C, R::FIELD);
+    }
+
+    const char* const invokes[] = {"invoke-virtual", "invoke-super", "invoke-direct", "invoke-static", "invoke-interface"};
+    const char* const invoke_ranges[] = {"invoke-virtual/range", "invoke-super/range", "invoke-direct/range",
+                                         "invoke-static/range", "invoke-interface/range"};
+    for (uint8_t i = 0; i < 5; ++i) {
+        set(0x6e + i, invokes[i], F::FORMAT_35C, R::METHOD);
+        set(0x74 + i, invoke_ranges[i], F::FORMAT_3RC, R::METHOD);
+    }
+
+    const char* const unary_ops[] = {
+        "neg-int", "not-int", "neg-long", "not-long", "neg-float", "neg-double",
+        "int-to-long", "int-to-float", "int-to-double",
+        "long-to-int", "long-to-float", "long-to-double",
+        "float-to-int", "float-to-long", "float-to-double",
+        "double-to-int", "double-to-long", "double-to-float",
+        "int-to-byte", "int-to-char", "int-to-short"};
+    for (uint8_t i = 0; i < 21; ++i) {
+        set(0x7b + i, unary_ops[i], F::FORMAT_12X);
+    }
+
+    // Three-register form at 0x90, /2addr form at 0xb0 with the same ordering
+    const char* const binary_ops[] = {
+        "add-int", "sub-int", "mul-int", "div-int", "rem-int", "and-int", "or-int", "xor-int", "shl-int", "shr-int", "ushr-int",
+        "add-long", "sub-long", "mul-long", "div-long", "rem-long", "and-long", "or-long", "xor-long", "shl-long", "shr-long", "ushr-long",
+        "add-float", "sub-float", "mul-float", "div-float", "rem-float",
+        "add-double", "sub-double", "mul-double", "div-double", "rem-double"};
+    const char* const binary_2addr_ops[] = {
+        "add-int/2addr", "sub-int/2addr", "mul-int/2addr", "div-int/2addr", "rem-int/2addr", "and-int/2addr",
+        "or-int/2addr", "xor-int/2addr", "shl-int/2addr", "shr-int/2addr", "ushr-int/2addr",
+        "add-long/2addr", "sub-long/2addr", "mul-long/2addr", "div-long/2addr", "rem-long/2addr", "and-long/2addr",
+        "or-long/2addr", "xor-long/2addr", "shl-long/2addr", "shr-long/2addr", "ushr-long/2addr",
+        "add-float/2addr", "sub-float/2addr", "mul-float/2addr", "div-float/2addr", "rem-float/2addr",
+        "add-double/2addr", "sub-double/2addr", "mul-double/2addr", "div-double/2addr", "rem-double/2addr"};
+    for (uint8_t i = 0; i < 32; ++i) {
+        set(0x90 + i, binary_ops[i], F::FORMAT_23X);
+        set(0xb0 + i, binary_2addr_ops[i], F::FORMAT_12X);
+    }
+
+    const char* const lit16_ops[] = {"add-int/lit16", "rsub-int", "mul-int/lit16", "div-int/lit16",
+                                     "rem-int/lit16", "and-int/lit16", "or-int/lit16", "xor-int/lit16"};
+    for (uint8_t i = 0; i < 8; ++i) {
+        set(0xd0 + i, lit16_ops[i], F::FORMAT_22S);
+    }
+
+    const char* const lit8_ops[] = {"add-int/lit8", "rsub-int/lit8", "mul-int/lit8", "div-int/lit8", "rem-int/lit8",
+                                    "and-int/lit8", "or-int/lit8", "xor-int/lit8", "shl-int/lit8", "shr-int/lit8",
+                                    "ushr-int/lit8"};
+    for (uint8_t i = 0; i < 11; ++i) {
+        set(0xd8 + i, lit8_ops[i], F::FORMAT_22B);
+    }
+
+    set(0xfa, "invoke-polymorphic", F::FORMAT_45CC, R::METHOD, 26);
+    set(0xfb, "invoke-polymorphic/range", F::FORMAT_4RCC, R::METHOD, 26);
+    set(0xfc, "invoke-custom", F::FORMAT_35C, R::CALL_SITE, 26);
+    set(0xfd, "invoke-custom/range", F::FORMAT_3RC, R::CALL_SITE, 26);
+    set(0xfe, "const-method-handle", F::FORMAT_21C, R::METHOD_HANDLE, 28);
+    set(0xff, "const-method-type", F::FORMAT_21C, R::PROTO, 28);
+
+    return table;
+}
+
+} // namespace opcode_table_detail
+
+// Dense per-opcode metadata, generated at compile time
+inline constexpr std::array<OpcodeInfo, 256> OPCODE_TABLE = opcode_table_detail::build();
+
+constexpr const OpcodeInfo& opcode_info(uint8_t opcode) {
+    return OPCODE_TABLE[opcode];
+}
+
+static_assert(OPCODE_TABLE[0x18].width == 5, "const-wide is 51l");
+static_assert(OPCODE_TABLE[0x6e].reference == ReferenceKind::METHOD, "invoke-virtual refers to a method");
+static_assert(format_layout(InstructionFormat::FORMAT_3RC).registers == RegisterOperands::RANGE, "3rc takes a register range");
+static_assert(OPCODE_TABLE[0x3e].name == nullptr, "0x3e is unused");
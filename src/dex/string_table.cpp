@@ -0,0 +1,47 @@
+#include "string_table.hpp"
+#include "../formatter/string_escape.hpp"
+#include <iostream>
+
+bool DexStringTable::load(ByteView file, uint32_t string_ids_off, uint32_t count) {
+    base_ = reinterpret_cast<const char*>(file.data());
+    entries_.clear();
+    entries_.reserve(count);
+    escaped_.reset(count);
+
+    if (string_ids_off > file.size() || (file.size() - string_ids_off) / sizeof(uint32_t) < count) {
+        std::cerr << "Error: String ID array access out of bounds" << std::endl;
+        return false;
+    }
+
+    const uint32_t* string_ids = reinterpret_cast<const uint32_t*>(file.data() + string_ids_off);
+    const uint8_t* file_end = file.data() + file.size();
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t string_data_off = string_ids[i];
+        if (string_data_off >= file.size()) {
+            std::cerr << "Error: Invalid string data offset" << std::endl;
+            return false;
+        }
+
+        // Skip the utf16_size prefix; the NUL terminator bounds the data
+        const uint8_t* ptr = file.data() + string_data_off;
+        while (ptr < file_end && (*ptr & 0x80)) {
+            ++ptr;
+        }
+        bool ascii = false;
+        size_t length = ptr < file_end ? scan_mutf8(++ptr, file_end, ascii) : SIZE_MAX;
+        if (length == SIZE_MAX) {
+            std::cerr << "Error: String extends beyond file boundary" << std::endl;
+            return false;
+        }
+
+        entries_.push_back({static_cast<uint32_t>(ptr - file.data()), static_cast<uint32_t>(length), ascii});
+    }
+    return true;
+}
+
+std::string DexStringTable::decode(uint32_t index) const {
+    // Non-ASCII characters become \uXXXX escapes, matching Java baksmali
+    OutputBuffer decoded(entries_[index].length * 2);
+    append_unicode_escaped(decoded, data(index));
+    return std::string(decoded.view());
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.hpp"
+#include "interned_string_table.hpp"
+
+// The string pool of a DEX file, decoded on demand.
+//
+// Loading only records where each string's MUTF-8 bytes are. ASCII strings,
+// which are nearly all of them, are returned as views straight into the file.
+// The rest are converted on first use, with non-ASCII characters written as
+// \uXXXX escapes, into a cache shared by all threads.
+class DexStringTable {
+public:
+    // Indexes `count` string_id_items at `string_ids_off`; false on a malformed pool
+    bool load(ByteView file, uint32_t string_ids_off, uint32_t count);
+
+    uint32_t size() const { return static_cast<uint32_t>(entries_.size()); }
+
+    // Out-of-range indices yield an empty string
+    std::string_view get(uint32_t index) const {
+        if (index >= entries_.size()) {
+            return {};
+        }
+        const Entry& entry = entries_[index];
+        if (entry.ascii) {
+            return std::string_view(base_ + entry.offset, entry.length);
+        }
+        return escaped_.get(index, [this](uint32_t i) { return decode(i); });
+    }
+
+    // The string's MUTF-8 bytes as stored, for writers that escape it themselves
+    std::string_view data(uint32_t index) const {
+        if (index >= entries_.size()) {
+            return {};
+        }
+        return std::string_view(base_ + entries_[index].offset, entries_[index].length);
+    }
+
+private:
+    struct Entry {
+        uint32_t offset;    // Of the character data, past the utf16_size prefix
+        uint32_t length;    // Bytes before the terminating NUL
+        bool ascii;
+    };
+
+    std::string decode(uint32_t index) const;
+
+    const char* base_ = nullptr;
+    std::vector<Entry> entries_;
+    InternedStringTable escaped_;
+};
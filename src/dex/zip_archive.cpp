@@ -0,0 +1,215 @@
+#include "zip_archive.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+#ifdef BAKSMALI_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr uint32_t END_OF_CENTRAL_DIR_SIGNATURE = 0x06054b50;
+
+constexpr size_t LOCAL_HEADER_SIZE = 30;
+constexpr size_t CENTRAL_HEADER_SIZE = 46;
+constexpr size_t END_OF_CENTRAL_DIR_SIZE = 22;
+constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+uint16_t read_u16(const uint8_t* ptr) {
+    return static_cast<uint16_t>(ptr[0] | (ptr[1] << 8));
+}
+
+uint32_t read_u32(const uint8_t* ptr) {
+    return static_cast<uint32_t>(ptr[0]) |
+           (static_cast<uint32_t>(ptr[1]) << 8) |
+           (static_cast<uint32_t>(ptr[2]) << 16) |
+           (static_cast<uint32_t>(ptr[3]) << 24);
+}
+
+// Returns the multidex ordinal of a top-level "classes<N>.dex" name, or 0 if it isn't one.
+// classes.dex is 1, classes2.dex is 2, ...
+uint32_t dex_entry_ordinal(const std::string& name) {
+    static const std::string prefix = "classes";
+    static const std::string suffix = ".dex";
+    if (name.size() < prefix.size() + suffix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return 0;
+    }
+
+    std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    if (digits.empty()) {
+        return 1;
+    }
+    if (digits.size() > 9 || !std::all_of(digits.begin(), digits.end(), ::isdigit)) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::stoul(digits));
+}
+
+} // namespace
+
+bool ZipArchive::is_zip(ByteView data) {
+    return data.size() >= LOCAL_HEADER_SIZE && read_u32(data.data()) == LOCAL_HEADER_SIGNATURE;
+}
+
+std::unique_ptr<ZipArchive> ZipArchive::open(std::shared_ptr<const MappedFile> file) {
+    auto archive = std::unique_ptr<ZipArchive>(new ZipArchive());
+    archive->data_ = file->view();
+    archive->file_ = std::move(file);
+
+    if (!archive->parse_central_directory()) {
+        return nullptr;
+    }
+    return archive;
+}
+
+bool ZipArchive::parse_central_directory() {
+    const uint8_t* base = data_.data();
+    size_t size = data_.size();
+
+    if (size < END_OF_CENTRAL_DIR_SIZE) {
+        std::cerr << "Error: File too small for ZIP archive" << std::endl;
+        return false;
+    }
+
+    // The end of central directory record sits at the end, followed by an optional comment
+    size_t search_floor = size > END_OF_CENTRAL_DIR_SIZE + MAX_COMMENT_SIZE
+                              ? size - END_OF_CENTRAL_DIR_SIZE - MAX_COMMENT_SIZE
+                              : 0;
+    size_t eocd = size - END_OF_CENTRAL_DIR_SIZE;
+    while (read_u32(base + eocd) != END_OF_CENTRAL_DIR_SIGNATURE) {
+        if (eocd == search_floor) {
+            std::cerr << "Error: ZIP end of central directory not found" << std::endl;
+            return false;
+        }
+        --eocd;
+    }
+
+    uint16_t entry_count = read_u16(base + eocd + 10);
+    uint32_t directory_size = read_u32(base + eocd + 12);
+    uint32_t directory_offset = read_u32(base + eocd + 16);
+
+    if (directory_offset == 0xFFFFFFFF || entry_count == 0xFFFF) {
+        std::cerr << "Error: ZIP64 archives are not supported" << std::endl;
+        return false;
+    }
+    if (static_cast<size_t>(directory_offset) + directory_size > eocd) {
+        std::cerr << "Error: ZIP central directory out of bounds" << std::endl;
+        return false;
+    }
+
+    entries_.reserve(entry_count);
+    const uint8_t* ptr = base + directory_offset;
+    const uint8_t* end = base + directory_offset + directory_size;
+
+    for (uint16_t i = 0; i < entry_count; ++i) {
+        if (ptr + CENTRAL_HEADER_SIZE > end || read_u32(ptr) != CENTRAL_HEADER_SIGNATURE) {
+            std::cerr << "Error: Corrupt ZIP central directory entry" << std::endl;
+            return false;
+        }
+
+        uint16_t name_length = read_u16(ptr + 28);
+        uint16_t extra_length = read_u16(ptr + 30);
+        uint16_t comment_length = read_u16(ptr + 32);
+        if (ptr + CENTRAL_HEADER_SIZE + name_length > end) {
+            std::cerr << "Error: Corrupt ZIP central directory entry" << std::endl;
+            return false;
+        }
+
+        ZipEntry entry;
+        entry.method = read_u16(ptr + 10);
+        entry.compressed_size = read_u32(ptr + 20);
+        entry.uncompressed_size = read_u32(ptr + 24);
+        entry.local_header_offset = read_u32(ptr + 42);
+        entry.name.assign(reinterpret_cast<const char*>(ptr + CENTRAL_HEADER_SIZE), name_length);
+        entries_.push_back(std::move(entry));
+
+        ptr += CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length;
+    }
+
+    return true;
+}
+
+std::vector<const ZipEntry*> ZipArchive::dex_entries() const {
+    std::vector<std::pair<uint32_t, const ZipEntry*>> ordered;
+    for (const auto& entry : entries_) {
+        uint32_t ordinal = dex_entry_ordinal(entry.name);
+        if (ordinal != 0) {
+            ordered.emplace_back(ordinal, &entry);
+        }
+    }
+
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    std::vector<const ZipEntry*> result;
+    result.reserve(ordered.size());
+    for (const auto& item : ordered) {
+        result.push_back(item.second);
+    }
+    return result;
+}
+
+std::optional<ByteView> ZipArchive::read_entry(const ZipEntry& entry, std::vector<uint8_t>& buffer) const {
+    const uint8_t* base = data_.data();
+    size_t size = data_.size();
+
+    // The local header repeats the name and carries its own extra field length
+    size_t header = entry.local_header_offset;
+    if (header + LOCAL_HEADER_SIZE > size || read_u32(base + header) != LOCAL_HEADER_SIGNATURE) {
+        std::cerr << "Error: Corrupt ZIP local header for " << entry.name << std::endl;
+        return std::nullopt;
+    }
+
+    size_t data_offset = header + LOCAL_HEADER_SIZE + read_u16(base + header + 26) + read_u16(base + header + 28);
+    if (data_offset + entry.compressed_size > size) {
+        std::cerr << "Error: ZIP entry data out of bounds for " << entry.name << std::endl;
+        return std::nullopt;
+    }
+
+    if (entry.method == ZIP_METHOD_STORED) {
+        return ByteView(base + data_offset, entry.compressed_size);
+    }
+
+    if (entry.method != ZIP_METHOD_DEFLATED) {
+        std::cerr << "Error: Unsupported ZIP compression method " << entry.method << " for " << entry.name << std::endl;
+        return std::nullopt;
+    }
+
+#ifdef BAKSMALI_HAVE_ZLIB
+    buffer.resize(entry.uncompressed_size);
+
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        std::cerr << "Error: Cannot initialise inflater for " << entry.name << std::endl;
+        return std::nullopt;
+    }
+
+    stream.next_in = const_cast<Bytef*>(base + data_offset);
+    stream.avail_in = entry.compressed_size;
+    stream.next_out = buffer.data();
+    stream.avail_out = entry.uncompressed_size;
+
+    int status = inflate(&stream, Z_FINISH);
+    uLong produced = stream.total_out;
+    inflateEnd(&stream);
+
+    if (status != Z_STREAM_END || produced != entry.uncompressed_size) {
+        std::cerr << "Error: Failed to inflate ZIP entry " << entry.name << std::endl;
+        return std::nullopt;
+    }
+
+    return ByteView(buffer.data(), buffer.size());
+#else
+    (void)buffer;
+    std::cerr << "Error: Cannot inflate " << entry.name << ": built without zlib support" << std::endl;
+    return std::nullopt;
+#endif
+}
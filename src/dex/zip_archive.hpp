@@ -0,0 +1,50 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Compression methods used by APK/JAR entries
+enum ZipCompressionMethod : uint16_t {
+    ZIP_METHOD_STORED = 0,
+    ZIP_METHOD_DEFLATED = 8
+};
+
+struct ZipEntry {
+    std::string name;
+    uint16_t method;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    uint32_t local_header_offset;
+};
+
+// Minimal read-only ZIP reader over a mapped APK/JAR/ZIP file.
+// Only the central directory is parsed; entry data is located on demand.
+class ZipArchive {
+public:
+    static bool is_zip(ByteView data);
+    static std::unique_ptr<ZipArchive> open(std::shared_ptr<const MappedFile> file);
+
+    const std::vector<ZipEntry>& entries() const { return entries_; }
+
+    // Top-level classes.dex, classes2.dex, ... in multidex order
+    std::vector<const ZipEntry*> dex_entries() const;
+
+    // Stored entries are returned as a view into the mapping. Deflated entries
+    // are inflated into `buffer` and the returned view points at it.
+    std::optional<ByteView> read_entry(const ZipEntry& entry, std::vector<uint8_t>& buffer) const;
+
+    const std::shared_ptr<const MappedFile>& file() const { return file_; }
+
+private:
+    ZipArchive() = default;
+
+    bool parse_central_directory();
+
+    std::shared_ptr<const MappedFile> file_;
+    ByteView data_;
+    std::vector<ZipEntry> entries_;
+};
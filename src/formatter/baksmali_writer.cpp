@@ -27,7 +27,7 @@ void BaksmaliWriter::write_class_footer() {
     // No specific footer needed for classes
 }
 
-void BaksmaliWriter::write_fields(const std::vector<DexField>& fields, bool is_static) {
+void BaksmaliWriter::write_fields(const std::pmr::vector<DexField>& fields, bool is_static) {
     for (const auto& field : fields) {
         write_field(field);
     }
@@ -42,7 +42,7 @@ void BaksmaliWriter::write_field(const DexField& field) {
     output_ << "\n";
 }
 
-void BaksmaliWriter::write_methods(const std::vector<DexMethod>& methods, bool is_direct) {
+void BaksmaliWriter::write_methods(const std::pmr::vector<DexMethod>& methods, bool is_direct) {
     for (const auto& method : methods) {
         write_method(method);
     }
@@ -71,7 +71,7 @@ void BaksmaliWriter::write_method_code(const DexMethod& method) {
     // Java baksmali adds blank lines after every instruction except the last one
     const auto& instructions = method.code->instructions;
     for (size_t i = 0; i < instructions.size(); ++i) {
-        write_instruction_with_method(instructions[i], instructions[i].address, &method, nullptr); // TODO: Pass DexFile
+        write_instruction_with_method(instructions[i], &method, nullptr); // TODO: Pass DexFile
 
         // Add blank line after every instruction except the last one (matching Java baksmali behavior)
         if (i != instructions.size() - 1) {
@@ -83,20 +83,18 @@ void BaksmaliWriter::write_method_code(const DexMethod& method) {
 }
 
 void BaksmaliWriter::write_instruction(const DexInstruction& instruction, uint32_t address) {
-    write_indented(instruction.mnemonic);
+    write_indented(DalvikInstructionParser::format_instruction(instruction, nullptr));
     // TODO: Add operand formatting
 }
 
-void BaksmaliWriter::write_instruction_with_method(const DexInstruction& instruction, uint32_t address, const DexMethod* method, const DexFile* dex_file) {
-    // Convert operands from uint32_t to uint16_t for the formatter
-    std::vector<uint16_t> operands_16;
-    for (uint32_t op : instruction.operands) {
-        operands_16.push_back(static_cast<uint16_t>(op));
-    }
-    
+void BaksmaliWriter::write_instruction_with_method(const DexInstruction& instruction, const DexMethod* method, const DexFile* dex_file) {
     // Re-format the instruction with method context for parameter registers
-    std::string formatted = DalvikInstructionParser::format_instruction_with_method(
-        operands_16.data(), address, dex_file, method);
+    RegisterNaming registers;
+    if (method && method->code) {
+        registers.registers_size = method->code->registers_size;
+        registers.ins_size = method->code->ins_size;
+    }
+    std::string formatted = DalvikInstructionParser::format_instruction(instruction, dex_file, registers);
     write_indented(formatted);
 }
 
@@ -156,11 +154,11 @@ void BaksmaliWriter::write_indented(const std::string& text) {
 }
 
 std::string BaksmaliWriter::format_method_signature(const DexMethod& method) {
-    return method.signature;
+    return std::string(method.signature);
 }
 
 std::string BaksmaliWriter::format_field_descriptor(const DexField& field) {
-    return field.name + ":" + field.type;
+    return std::string(field.name) + ":" + std::string(field.type);
 }
 
 std::string BaksmaliWriter::escape_string(const std::string& str) {
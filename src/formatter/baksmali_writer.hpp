@@ -15,17 +15,17 @@ public:
     void write_class_footer();
     
     // Field writing
-    void write_fields(const std::vector<DexField>& fields, bool is_static);
+    void write_fields(const std::pmr::vector<DexField>& fields, bool is_static);
     void write_field(const DexField& field);
     
     // Method writing
-    void write_methods(const std::vector<DexMethod>& methods, bool is_direct);
+    void write_methods(const std::pmr::vector<DexMethod>& methods, bool is_direct);
     void write_method(const DexMethod& method);
     void write_method_code(const DexMethod& method);
     
     // Instruction writing
     void write_instruction(const DexInstruction& instruction, uint32_t address);
-    void write_instruction_with_method(const DexInstruction& instruction, uint32_t address, const struct DexMethod* method, const class DexFile* dex_file);
+    void write_instruction_with_method(const DexInstruction& instruction, const struct DexMethod* method, const class DexFile* dex_file);
     
     // Utility methods
     void write_access_flags(uint32_t flags, bool is_class = false);
@@ -0,0 +1,101 @@
+#include "hex_array.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t BLOCK_BYTES = 16;
+
+int64_t read_signed(const uint8_t* data, uint32_t width) {
+    switch (width) {
+        case 1: return static_cast<int8_t>(data[0]);
+        case 2: { int16_t v; std::memcpy(&v, data, 2); return v; }
+        case 4: { int32_t v; std::memcpy(&v, data, 4); return v; }
+        default: { int64_t v; std::memcpy(&v, data, 8); return v; }
+    }
+}
+
+// Hex digits of `bytes` (most significant byte first), two per byte
+void expand_hex(const uint8_t* bytes, char* digits) {
+#if defined(__SSE2__)
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i high = _mm_and_si128(_mm_srli_epi16(value, 4), mask);
+    __m128i low = _mm_and_si128(value, mask);
+
+    // Interleave so each byte yields its high then low nibble
+    __m128i first = _mm_unpacklo_epi8(high, low);
+    __m128i second = _mm_unpackhi_epi8(high, low);
+
+    // '0' + n, plus ('a' - '0' - 10) where n > 9
+    __m128i zero = _mm_set1_epi8('0');
+    __m128i nine = _mm_set1_epi8(9);
+    __m128i letter_gap = _mm_set1_epi8('a' - '0' - 10);
+    first = _mm_add_epi8(_mm_add_epi8(first, zero), _mm_and_si128(_mm_cmpgt_epi8(first, nine), letter_gap));
+    second = _mm_add_epi8(_mm_add_epi8(second, zero), _mm_and_si128(_mm_cmpgt_epi8(second, nine), letter_gap));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digits), first);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digits + 16), second);
+#else
+    static constexpr char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < BLOCK_BYTES; ++i) {
+        digits[i * 2] = hex[bytes[i] >> 4];
+        digits[i * 2 + 1] = hex[bytes[i] & 0xF];
+    }
+#endif
+}
+
+} // namespace
+
+void append_hex_array(OutputBuffer& out, const uint8_t* data, uint32_t element_width, uint32_t count,
+                      std::string_view indent, std::string_view suffix) {
+    if (element_width != 1 && element_width != 2 && element_width != 4 && element_width != 8) {
+        return;
+    }
+
+    const uint32_t per_block = BLOCK_BYTES / element_width;
+    uint8_t magnitudes[BLOCK_BYTES];
+    bool negative[BLOCK_BYTES];
+    bool long_value[BLOCK_BYTES];
+    char digits[BLOCK_BYTES * 2];
+
+    for (uint32_t start = 0; start < count; start += per_block) {
+        uint32_t block = count - start < per_block ? count - start : per_block;
+
+        // Magnitudes laid out big-endian, element by element
+        std::memset(magnitudes, 0, sizeof(magnitudes));
+        for (uint32_t i = 0; i < block; ++i) {
+            int64_t value = read_signed(data + static_cast<size_t>(start + i) * element_width, element_width);
+            negative[i] = value < 0;
+            long_value[i] = value < INT32_MIN || value > INT32_MAX;
+            uint64_t magnitude = negative[i] ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+            uint8_t* slot = magnitudes + i * element_width;
+            for (uint32_t b = 0; b < element_width; ++b) {
+                slot[element_width - 1 - b] = static_cast<uint8_t>(magnitude >> (b * 8));
+            }
+        }
+
+        expand_hex(magnitudes, digits);
+
+        for (uint32_t i = 0; i < block; ++i) {
+            const char* first = digits + i * element_width * 2;
+            const char* last = first + element_width * 2 - 1;
+            while (first < last && *first == '0') {
+                ++first;
+            }
+
+            out.append(indent);
+            out.append(negative[i] ? std::string_view("-0x") : std::string_view("0x"));
+            out.append(std::string_view(first, last - first + 1));
+            if (long_value[i]) {
+                out.append('L');
+            }
+            out.append(suffix);
+            out.append('\n');
+        }
+    }
+}
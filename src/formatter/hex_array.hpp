@@ -0,0 +1,15 @@
+#pragma once
+
+#include "output_buffer.hpp"
+#include <cstdint>
+#include <string_view>
+
+// Writes `count` little-endian signed integers of `element_width` bytes
+// (1, 2, 4 or 8) as one line each: indent, signed hex ("0x1f", "-0x2"), suffix.
+// Values outside the int range get an L, as baksmali prints longs.
+//
+// Digits for a block of elements are produced together from their big-endian
+// magnitudes (16 bytes at a time with SSE2, a byte-pair table otherwise) and
+// copied out without leading zeros; nothing is allocated per element.
+void append_hex_array(OutputBuffer& out, const uint8_t* data, uint32_t element_width, uint32_t count,
+                      std::string_view indent, std::string_view suffix);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace output_buffer_detail {
+
+constexpr std::array<char, 512> make_hex_pairs() {
+    constexpr char digits[] = "0123456789abcdef";
+    std::array<char, 512> pairs{};
+    for (size_t i = 0; i < 256; ++i) {
+        pairs[i * 2] = digits[i >> 4];
+        pairs[i * 2 + 1] = digits[i & 0xF];
+    }
+    return pairs;
+}
+
+// "00", "01", ... "ff" laid out back to back
+inline constexpr std::array<char, 512> HEX_PAIRS = make_hex_pairs();
+
+} // namespace output_buffer_detail
+
+// Growable character buffer that formatting code appends into.
+//
+// Numbers are converted with std::to_chars and a two-digit hex lookup table,
+// so appending never touches locales or stream state. Once the buffer has
+// grown to its working size, reusing it (clear() between uses) performs no
+// further heap allocation.
+class OutputBuffer {
+public:
+    OutputBuffer() = default;
+    explicit OutputBuffer(size_t capacity) { data_.reserve(capacity); }
+
+    void append(std::string_view text) { data_.append(text.data(), text.size()); }
+    void append(char c) { data_.push_back(c); }
+    void append(size_t count, char c) { data_.append(count, c); }
+
+    template <typename Integer>
+    void append_decimal(Integer value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        data_.append(digits, result.ptr - digits);
+    }
+
+    // Lowercase hex without a prefix, e.g. 255 -> "ff"
+    void append_hex(uint64_t value) {
+        char digits[16];
+        char* end = digits + sizeof(digits);
+        char* ptr = end;
+        while (value >= 0x100) {
+            ptr -= 2;
+            const char* pair = &HEX_PAIRS[(value & 0xFF) * 2];
+            ptr[0] = pair[0];
+            ptr[1] = pair[1];
+            value >>= 8;
+        }
+        if (value >= 0x10) {
+            ptr -= 2;
+            ptr[0] = HEX_PAIRS[value * 2];
+            ptr[1] = HEX_PAIRS[value * 2 + 1];
+        } else {
+            *--ptr = HEX_PAIRS[value * 2 + 1];
+        }
+        data_.append(ptr, end - ptr);
+    }
+
+    // Stream-style appends, so formatting code reads like the ostream code it replaces
+    OutputBuffer& operator<<(std::string_view text) {
+        append(text);
+        return *this;
+    }
+    OutputBuffer& operator<<(char c) {
+        append(c);
+        return *this;
+    }
+    template <typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer> &&
+                                                            !std::is_same_v<Integer, char> &&
+                                                            !std::is_same_v<Integer, bool>>>
+    OutputBuffer& operator<<(Integer value) {
+        append_decimal(value);
+        return *this;
+    }
+
+    std::string_view view() const { return data_; }
+    const char* data() const { return data_.data(); }
+    size_t size() const { return data_.size(); }
+    bool empty() const { return data_.empty(); }
+
+    size_t capacity() const { return data_.capacity(); }
+
+    void clear() { data_.clear(); }
+    // Empties the buffer and hands its storage back to the heap
+    void release() { std::string().swap(data_); }
+    void truncate(size_t size) { data_.resize(size); }
+    void reserve(size_t capacity) { data_.reserve(capacity); }
+
+private:
+    static constexpr const std::array<char, 512>& HEX_PAIRS = output_buffer_detail::HEX_PAIRS;
+
+    std::string data_;
+};
@@ -0,0 +1,262 @@
+#include "string_escape.hpp"
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BAKSMALI_AVX2_DISPATCH 1
+#endif
+
+namespace {
+
+// Bytes a literal cannot copy as-is: controls, DEL and above, quotes, backslash
+bool is_literal_special(uint8_t c) {
+    return c < 0x20 || c >= 0x7f || c == '"' || c == '\'' || c == '\\';
+}
+
+// Each kernel returns how many leading bytes need no attention
+struct Kernels {
+    size_t (*ascii_run)(const char* data, size_t size);
+    size_t (*literal_run)(const char* data, size_t size);
+    // Offset of the first NUL (or `end - data`), ORing the bytes before it into `high`
+    size_t (*terminator)(const uint8_t* data, const uint8_t* end, uint8_t& high);
+};
+
+size_t ascii_run_scalar(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size && static_cast<uint8_t>(data[i]) < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+size_t literal_run_scalar(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size && !is_literal_special(static_cast<uint8_t>(data[i]))) {
+        ++i;
+    }
+    return i;
+}
+
+size_t terminator_scalar(const uint8_t* data, const uint8_t* end, uint8_t& high) {
+    const uint8_t* ptr = data;
+    while (ptr < end && *ptr != 0) {
+        high |= *ptr++;
+    }
+    return ptr - data;
+}
+
+constexpr Kernels SCALAR_KERNELS = {ascii_run_scalar, literal_run_scalar, terminator_scalar};
+
+#if defined(__SSE2__)
+
+__m128i literal_specials_sse2(__m128i v) {
+    // Signed compare: bytes of 0x80 and above are negative, so also "below 0x20"
+    __m128i special = _mm_cmplt_epi8(v, _mm_set1_epi8(0x20));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+    return _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+}
+
+size_t ascii_run_sse2(const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + ascii_run_scalar(data + i, size - i);
+}
+
+size_t literal_run_sse2(const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int mask = _mm_movemask_epi8(literal_specials_sse2(v));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + literal_run_scalar(data + i, size - i);
+}
+
+size_t terminator_sse2(const uint8_t* data, const uint8_t* end, uint8_t& high) {
+    const uint8_t* ptr = data;
+    int high_mask = 0;
+    for (; end - ptr >= 16; ptr += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+        int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        int highs = _mm_movemask_epi8(v);
+        if (zeros) {
+            int at = __builtin_ctz(zeros);
+            high |= ((highs & ((1 << at) - 1)) | high_mask) ? 0x80 : 0;
+            return (ptr - data) + at;
+        }
+        high_mask |= highs;
+    }
+    high |= high_mask ? 0x80 : 0;
+    return (ptr - data) + terminator_scalar(ptr, end, high);
+}
+
+constexpr Kernels SSE2_KERNELS = {ascii_run_sse2, literal_run_sse2, terminator_sse2};
+
+#endif
+
+#if defined(BAKSMALI_AVX2_DISPATCH)
+
+__attribute__((target("avx2"))) size_t ascii_run_avx2(const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + ascii_run_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) size_t literal_run_avx2(const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i special = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v);
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f)));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + literal_run_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) size_t terminator_avx2(const uint8_t* data, const uint8_t* end, uint8_t& high) {
+    const uint8_t* ptr = data;
+    uint32_t high_mask = 0;
+    for (; end - ptr >= 32; ptr += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        uint32_t zeros = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+        uint32_t highs = static_cast<uint32_t>(_mm256_movemask_epi8(v));
+        if (zeros) {
+            int at = __builtin_ctz(zeros);
+            high |= ((highs & ((uint32_t(1) << at) - 1)) | high_mask) ? 0x80 : 0;
+            return (ptr - data) + at;
+        }
+        high_mask |= highs;
+    }
+    high |= high_mask ? 0x80 : 0;
+    return (ptr - data) + terminator_scalar(ptr, end, high);
+}
+
+constexpr Kernels AVX2_KERNELS = {ascii_run_avx2, literal_run_avx2, terminator_avx2};
+
+#endif
+
+const Kernels& select_kernels() {
+#if defined(BAKSMALI_AVX2_DISPATCH)
+    if (__builtin_cpu_supports("avx2")) {
+        return AVX2_KERNELS;
+    }
+#endif
+#if defined(__SSE2__)
+    return SSE2_KERNELS;
+#else
+    return SCALAR_KERNELS;
+#endif
+}
+
+const Kernels& kernels() {
+    static const Kernels& selected = select_kernels();
+    return selected;
+}
+
+// Reads one UTF-16 unit from the MUTF-8 sequence at data[i], advancing i past it.
+// Invalid or truncated sequences are taken as a single byte.
+uint32_t read_unit(const char* data, size_t size, size_t& i) {
+    uint8_t c = static_cast<uint8_t>(data[i]);
+    size_t remaining = size - i;
+    uint32_t unit = c;
+    if ((c & 0xE0) == 0xC0 && remaining >= 2) {
+        unit = ((c & 0x1F) << 6) | (data[i + 1] & 0x3F);
+        i += 2;
+    } else if ((c & 0xF0) == 0xE0 && remaining >= 3) {
+        unit = ((c & 0x0F) << 12) | ((data[i + 1] & 0x3F) << 6) | (data[i + 2] & 0x3F);
+        i += 3;
+    } else if ((c & 0xF8) == 0xF0 && remaining >= 4) {
+        unit = ((c & 0x07) << 18) | ((data[i + 1] & 0x3F) << 12) | ((data[i + 2] & 0x3F) << 6) | (data[i + 3] & 0x3F);
+        i += 4;
+    } else {
+        i += 1;
+    }
+    return unit & 0xFFFF;
+}
+
+void append_unit_escape(OutputBuffer& out, uint32_t unit) {
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    char escape[6] = {'\\', 'u', DIGITS[(unit >> 12) & 0xF], DIGITS[(unit >> 8) & 0xF],
+                      DIGITS[(unit >> 4) & 0xF], DIGITS[unit & 0xF]};
+    out.append(std::string_view(escape, sizeof(escape)));
+}
+
+} // namespace
+
+size_t scan_mutf8(const uint8_t* data, const uint8_t* end, bool& ascii) {
+    uint8_t high = 0;
+    size_t length = kernels().terminator(data, end, high);
+    if (data + length >= end) {
+        return SIZE_MAX;
+    }
+    ascii = (high & 0x80) == 0;
+    return length;
+}
+
+void append_unicode_escaped(OutputBuffer& out, std::string_view mutf8) {
+    const Kernels& k = kernels();
+    size_t i = 0;
+    while (i < mutf8.size()) {
+        size_t run = k.ascii_run(mutf8.data() + i, mutf8.size() - i);
+        out.append(mutf8.substr(i, run));
+        i += run;
+        if (i < mutf8.size()) {
+            append_unit_escape(out, read_unit(mutf8.data(), mutf8.size(), i));
+        }
+    }
+}
+
+void append_escaped_literal(OutputBuffer& out, std::string_view mutf8) {
+    const Kernels& k = kernels();
+    size_t i = 0;
+    while (i < mutf8.size()) {
+        size_t run = k.literal_run(mutf8.data() + i, mutf8.size() - i);
+        out.append(mutf8.substr(i, run));
+        i += run;
+        if (i >= mutf8.size()) {
+            break;
+        }
+
+        uint32_t unit = read_unit(mutf8.data(), mutf8.size(), i);
+        switch (unit) {
+            case '"': out.append("\\\""); break;
+            case '\'': out.append("\\'"); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (unit >= 0x20 && unit < 0x7f) {
+                    out.append(static_cast<char>(unit));
+                } else {
+                    append_unit_escape(out, unit);
+                }
+                break;
+        }
+    }
+}
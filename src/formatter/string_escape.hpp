@@ -0,0 +1,25 @@
+#pragma once
+
+#include "output_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// MUTF-8 scanning and escaping shared by the string pool and the writers.
+//
+// Strings are overwhelmingly plain ASCII, so each routine looks for the next
+// byte that needs attention 16 (SSE2) or 32 (AVX2) bytes at a time and copies
+// the clean run in one append. The vector width is picked once at run time
+// from the CPU; other targets use a scalar loop.
+
+// Length of the NUL-terminated string at `data`, or SIZE_MAX when no NUL comes
+// before `end`. `ascii` tells whether every byte before the NUL is below 0x80.
+size_t scan_mutf8(const uint8_t* data, const uint8_t* end, bool& ascii);
+
+// Appends MUTF-8 string data with every non-ASCII UTF-16 unit as \uXXXX
+void append_unicode_escaped(OutputBuffer& out, std::string_view mutf8);
+
+// Appends MUTF-8 string data as the inside of a smali string literal, the way
+// baksmali writes it: quotes and backslashes are escaped, \n \r \t are named,
+// and other control characters and non-ASCII units become \uXXXX
+void append_escaped_literal(OutputBuffer& out, std::string_view mutf8);
@@ -0,0 +1,33 @@
+#include "memory_window.hpp"
+#include <algorithm>
+
+void MemoryWindow::acquire(uint64_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto fits = [this, bytes] {
+        return budget_ == 0 || in_flight_ == 0 || in_flight_ + bytes <= budget_;
+    };
+    if (!fits()) {
+        ++waits_;
+        released_.wait(lock, fits);
+    }
+    in_flight_ += bytes;
+    peak_ = std::max(peak_, in_flight_);
+}
+
+void MemoryWindow::release(uint64_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_ -= bytes;
+    }
+    released_.notify_all();
+}
+
+uint64_t MemoryWindow::peak() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
+}
+
+uint64_t MemoryWindow::wait_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waits_;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Caps the estimated bytes of classes that workers hold at once.
+//
+// A worker reserves a class's footprint before parsing it and hands it back
+// once the class file is written, so parsed and rendered classes move through
+// a window of at most `budget` bytes however large the DEX is. A class that is
+// larger than the whole budget is still admitted, but only while nothing else
+// is in flight.
+class MemoryWindow {
+public:
+    // A budget of 0 admits everything
+    explicit MemoryWindow(uint64_t budget) : budget_(budget) {}
+
+    MemoryWindow(const MemoryWindow&) = delete;
+    MemoryWindow& operator=(const MemoryWindow&) = delete;
+
+    // Blocks until `bytes` fits in what is left of the budget
+    void acquire(uint64_t bytes);
+    void release(uint64_t bytes);
+
+    uint64_t budget() const { return budget_; }
+    // Most bytes ever in flight, and how many admissions had to wait
+    uint64_t peak() const;
+    uint64_t wait_count() const;
+
+private:
+    const uint64_t budget_;
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    uint64_t in_flight_ = 0;
+    uint64_t peak_ = 0;
+    uint64_t waits_ = 0;
+};